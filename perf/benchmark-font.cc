@@ -25,10 +25,12 @@ enum operation_t
 {
   nominal_glyphs,
   glyph_h_advances,
+  glyph_v_advances,
   glyph_extents,
   draw_glyph,
   paint_glyph,
   load_face_and_shape,
+  freeze_instance,
 };
 
 static void
@@ -135,6 +137,7 @@ static void BM_Font (benchmark::State &state,
       break;
     }
     case glyph_h_advances:
+    case glyph_v_advances:
     {
       hb_codepoint_t *glyphs = (hb_codepoint_t *) calloc (num_glyphs, sizeof (hb_codepoint_t));
       hb_position_t *advances = (hb_position_t *) calloc (num_glyphs, sizeof (hb_codepoint_t));
@@ -142,11 +145,23 @@ static void BM_Font (benchmark::State &state,
       for (unsigned g = 0; g < num_glyphs; g++)
         glyphs[g] = g;
 
-      for (auto _ : state)
-	hb_font_get_glyph_h_advances (font,
-				      num_glyphs,
-				      glyphs, sizeof (*glyphs),
-				      advances, sizeof (*advances));
+      if (operation == glyph_h_advances)
+	for (auto _ : state)
+	  hb_font_get_glyph_h_advances (font,
+					num_glyphs,
+					glyphs, sizeof (*glyphs),
+					advances, sizeof (*advances));
+      else
+	for (auto _ : state)
+	  hb_font_get_glyph_v_advances (font,
+					num_glyphs,
+					glyphs, sizeof (*glyphs),
+					advances, sizeof (*advances));
+
+      /* Reported as time per glyph. */
+      state.counters["glyph"] = benchmark::Counter (num_glyphs,
+						    benchmark::Counter::kIsIterationInvariantRate |
+						    benchmark::Counter::kInvert);
 
       free (advances);
       free (glyphs);
@@ -158,6 +173,11 @@ static void BM_Font (benchmark::State &state,
       for (auto _ : state)
 	for (unsigned gid = 0; gid < num_glyphs; ++gid)
 	  hb_font_get_glyph_extents (font, gid, &extents);
+
+      /* Reported as time per glyph. */
+      state.counters["glyph"] = benchmark::Counter (num_glyphs,
+						    benchmark::Counter::kIsIterationInvariantRate |
+						    benchmark::Counter::kInvert);
       break;
     }
     case draw_glyph:
@@ -170,6 +190,11 @@ static void BM_Font (benchmark::State &state,
 	  hb_font_draw_glyph (font, gid, draw_funcs, &i);
       }
       hb_draw_funcs_destroy (draw_funcs);
+
+      /* Reported as time per glyph. */
+      state.counters["glyph"] = benchmark::Counter (num_glyphs,
+						    benchmark::Counter::kIsIterationInvariantRate |
+						    benchmark::Counter::kInvert);
       break;
     }
     case paint_glyph:
@@ -211,6 +236,15 @@ static void BM_Font (benchmark::State &state,
       }
       break;
     }
+    case freeze_instance:
+    {
+      unsigned memory = 0;
+      for (auto _ : state)
+	hb_font_freeze_instance (font, &memory);
+
+      state.counters["memory"] = memory;
+      break;
+    }
   }
 
 
@@ -274,10 +308,12 @@ int main(int argc, char** argv)
 
   TEST_OPERATION (nominal_glyphs, benchmark::kMicrosecond);
   TEST_OPERATION (glyph_h_advances, benchmark::kMicrosecond);
+  TEST_OPERATION (glyph_v_advances, benchmark::kMicrosecond);
   TEST_OPERATION (glyph_extents, benchmark::kMicrosecond);
   TEST_OPERATION (draw_glyph, benchmark::kMillisecond);
   TEST_OPERATION (paint_glyph, benchmark::kMillisecond);
   TEST_OPERATION (load_face_and_shape, benchmark::kMicrosecond);
+  TEST_OPERATION (freeze_instance, benchmark::kMillisecond);
 
 #undef TEST_OPERATION
 
@@ -85,6 +85,43 @@ static void BM_Shape (benchmark::State &state,
   hb_font_destroy (font);
 }
 
+static void BM_ShapeLong (benchmark::State &state,
+			  const test_input_t &input)
+{
+  hb_font_t *font;
+  {
+    hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+    assert (face);
+    font = hb_font_create (face);
+    hb_face_destroy (face);
+  }
+
+  if (variation)
+  {
+    hb_variation_t var;
+    hb_variation_from_string (variation, -1, &var);
+    hb_font_set_variations (font, &var, 1);
+  }
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+
+  hb_buffer_t *buf = hb_buffer_create ();
+  for (auto _ : state)
+  {
+    hb_buffer_clear_contents (buf);
+    hb_buffer_add_utf8 (buf, text, text_length, 0, text_length);
+    hb_buffer_guess_segment_properties (buf);
+    hb_shape (font, buf, nullptr, 0);
+  }
+  hb_buffer_destroy (buf);
+
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
 static void test_shaper (const char *shaper,
 			 const test_input_t &test_input)
 {
@@ -103,6 +140,21 @@ static void test_shaper (const char *shaper,
    ->Unit(benchmark::kMillisecond);
 }
 
+static void test_long (const test_input_t &test_input)
+{
+  char name[1024] = "BM_ShapeLong";
+  const char *p;
+  strcat (name, "/");
+  p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+  strcat (name, "/");
+  p = strrchr (test_input.text_path, '/');
+  strcat (name, p ? p + 1 : test_input.text_path);
+
+  benchmark::RegisterBenchmark (name, BM_ShapeLong, test_input)
+   ->Unit(benchmark::kMillisecond);
+}
+
 int main(int argc, char** argv)
 {
   benchmark::Initialize(&argc, argv);
@@ -124,6 +176,7 @@ int main(int argc, char** argv)
     const char **shapers = hb_shape_list_shapers ();
     for (const char **shaper = shapers; *shaper; shaper++)
       test_shaper (*shaper, test_input);
+    test_long (test_input);
   }
 
   benchmark::RunSpecifiedBenchmarks();
@@ -2,12 +2,21 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
+
+static double draw_all (hb_font_t *font, hb_draw_funcs_t *funcs, unsigned glyph_count)
+{
+  clock_t start = clock ();
+  for (unsigned gid = 0; gid < glyph_count; gid++)
+    hb_font_draw_glyph (font, gid, funcs, NULL);
+  return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
 
 int main (int argc, char **argv)
 {
   if (argc < 2)
   {
-    fprintf (stderr, "Usage: %s font-file [font-funcs] [wght]\n", argv[0]);
+    fprintf (stderr, "Usage: %s font-file [font-funcs] [wght] [outline-cache-bytes]\n", argv[0]);
     return 1;
   }
 
@@ -35,8 +44,25 @@ int main (int argc, char **argv)
   hb_draw_funcs_t *funcs = hb_draw_funcs_create ();
 
   unsigned glyph_count = hb_face_get_glyph_count (face);
-  for (unsigned gid = 0; gid < glyph_count; gid++)
-    hb_font_draw_glyph (font, gid, funcs, NULL);
+
+  if (argc > 4)
+  {
+    /* Draw everything twice through the outline cache, to compare
+     * decoding the outlines (cold) with replaying them (warm). */
+    hb_font_set_outline_cache (font, strtoul (argv[4], NULL, 10));
+
+    double cold = draw_all (font, funcs, glyph_count);
+    double warm = draw_all (font, funcs, glyph_count);
+
+    unsigned hits, misses, evictions, memory;
+    hb_font_get_outline_cache_stats (font, &hits, &misses, &evictions, &memory);
+
+    printf ("cold: %.3fms (%.0f glyphs/s)\n", cold * 1000, cold ? glyph_count / cold : 0.);
+    printf ("warm: %.3fms (%.0f glyphs/s)\n", warm * 1000, warm ? glyph_count / warm : 0.);
+    printf ("hits: %u misses: %u evictions: %u memory: %u\n", hits, misses, evictions, memory);
+  }
+  else
+    draw_all (font, funcs, glyph_count);
 
   hb_draw_funcs_destroy (funcs);
   hb_font_destroy (font);
@@ -123,11 +123,49 @@ struct PairPosFormat2_4 : ValueBase
 
   const Coverage &get_coverage () const { return this+coverage; }
 
+  /* Subtables that only adjust the x-advance of the first glyph are
+   * plain kerning.  We decode their design-unit values once into a
+   * dense class1-major matrix, making kerning a pair a single indexed
+   * load.  The matrix is shared by all fonts of the face, so it only
+   * holds the instance-independent part; an xAdvDevice delta, which
+   * depends on the font's ppem and variation coordinates, is still
+   * evaluated per pair, through the font's VarStore cache. */
+  static constexpr unsigned MAX_KERN_MATRIX_LENGTH = 1u << 17;
+
+  bool is_simple_kern () const
+  {
+    unsigned format = valueFormat1;
+    return format && !(format & ~(ValueFormat::xAdvance | ValueFormat::xAdvDevice)) && !valueFormat2;
+  }
+
+  int16_t *create_kern_matrix () const
+  {
+    if (!is_simple_kern ()) return nullptr;
+
+    unsigned count = (unsigned) class1Count * (unsigned) class2Count;
+    if (!count || count > MAX_KERN_MATRIX_LENGTH) return nullptr;
+
+    int16_t *kerns = (int16_t *) hb_malloc (count * sizeof (kerns[0]));
+    if (unlikely (!kerns)) return nullptr;
+
+    if (valueFormat1 & ValueFormat::xAdvance)
+    {
+      unsigned len1 = valueFormat1.get_len ();
+      const Value *v = &values[0];
+      for (unsigned i = 0; i < count; i++)
+	kerns[i] = v[i * len1];
+    }
+    else
+      hb_memset (kerns, 0, count * sizeof (kerns[0]));
+    return kerns;
+  }
+
   struct pair_pos_cache_t
   {
     hb_ot_lookup_cache_t coverage;
     hb_ot_lookup_cache_t first;
     hb_ot_lookup_cache_t second;
+    int16_t *kerns; /* See create_kern_matrix(); may be nullptr. */
   };
 
   unsigned cache_cost () const
@@ -140,12 +178,14 @@ struct PairPosFormat2_4 : ValueBase
     {
       case hb_ot_lookup_cache_op_t::CREATE:
       {
+	const PairPosFormat2_4 *thiz = (const PairPosFormat2_4 *) p;
 	pair_pos_cache_t *cache = (pair_pos_cache_t *) hb_malloc (sizeof (pair_pos_cache_t));
 	if (likely (cache))
 	{
 	  cache->coverage.clear ();
 	  cache->first.clear ();
 	  cache->second.clear ();
+	  cache->kerns = thiz ? thiz->create_kern_matrix () : nullptr;
 	}
 	return cache;
       }
@@ -156,6 +196,8 @@ struct PairPosFormat2_4 : ValueBase
       case hb_ot_lookup_cache_op_t::DESTROY:
 	{
 	  pair_pos_cache_t *cache = (pair_pos_cache_t *) p;
+	  if (cache)
+	    hb_free (cache->kerns);
 	  hb_free (cache);
 	  return nullptr;
 	}
@@ -209,6 +251,23 @@ struct PairPosFormat2_4 : ValueBase
 
     bool applied_first = false, applied_second = false;
 
+#if !defined(HB_NO_OT_LAYOUT_LOOKUP_CACHE) && !defined(HB_SPLIT_KERN)
+    if (cache && cache->kerns &&
+	HB_DIRECTION_IS_HORIZONTAL (c->direction) &&
+	!(HB_BUFFER_MESSAGE_MORE && c->buffer->messaging ()))
+    {
+      hb_position_t &x_advance = buffer->cur_pos().x_advance;
+      int kern = cache->kerns[klass1 * class2Count + klass2];
+      if (kern)
+      {
+	x_advance += c->font->em_scale_x (kern);
+	applied_first = true;
+      }
+      if (valueFormat1 & ValueFormat::xAdvDevice)
+	x_advance += valueFormat1.get_x_advance_delta (c, this, v, &applied_first);
+      goto success;
+    }
+#endif
 
     /* Isolate simple kerning and apply it half to each side.
      * Results in better cursor positioning / underline drawing.
@@ -144,6 +144,24 @@ struct ValueFormat : HBUINT16
     return ret;
   }
 
+  /* The x_advance Device delta apply_value() adds to a record in
+   * horizontal direction, for callers that handle the rest of the
+   * record themselves. */
+  hb_position_t get_x_advance_delta (hb_ot_apply_context_t *c,
+				     const ValueBase       *base,
+				     const Value           *values,
+				     bool                  *worked) const
+  {
+    unsigned int format = *this;
+    if (!(format & xAdvDevice)) return 0;
+
+    hb_font_t *font = c->font;
+    if (!font->x_ppem && !font->num_coords) return 0;
+
+    values += hb_popcount (format & (xAdvDevice - 1));
+    return get_device (values, worked, base, c->sanitizer).get_x_delta (font, c->var_store, c->var_store_cache);
+  }
+
   unsigned int get_effective_format (const Value *values, bool strip_hints, bool strip_empty, const ValueBase *base,
                                      const hb_hashmap_t<unsigned, hb_pair_t<unsigned, int>> *varidx_delta_map) const
   {
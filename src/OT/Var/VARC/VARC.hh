@@ -3,6 +3,7 @@
 
 #include "../../../hb-decycler.hh"
 #include "../../../hb-geometry.hh"
+#include "../../../hb-sharded-pool.hh"
 #include "../../../hb-ot-layout-common.hh"
 #include "../../../hb-ot-glyf-table.hh"
 #include "../../../hb-ot-cff2-table.hh"
@@ -167,16 +168,13 @@ struct VARC
     }
     ~accelerator_t ()
     {
-      auto *scratch = cached_scratch.get_relaxed ();
-      if (scratch)
-      {
-	scratch->~hb_varc_scratch_t ();
-	hb_free (scratch);
-      }
+      scratch_pool.clear (destroy_scratch);
 
       table.destroy ();
     }
 
+    bool has_data () const { return table->has_data (); }
+
     bool
     get_path (hb_font_t *font, hb_codepoint_t gid, hb_draw_session_t &draw_session) const
     {
@@ -213,29 +211,23 @@ struct VARC
 
     hb_varc_scratch_t *acquire_scratch () const
     {
-      hb_varc_scratch_t *scratch = cached_scratch.get_acquire ();
-
-      if (!scratch || unlikely (!cached_scratch.cmpexch (scratch, nullptr)))
-      {
-	scratch = (hb_varc_scratch_t *) hb_calloc (1, sizeof (hb_varc_scratch_t));
-	if (unlikely (!scratch))
-	  return nullptr;
-      }
-
-      return scratch;
+      return scratch_pool.acquire ([] () {
+	return (hb_varc_scratch_t *) hb_calloc (1, sizeof (hb_varc_scratch_t));
+      });
     }
     void release_scratch (hb_varc_scratch_t *scratch) const
     {
-      if (!cached_scratch.cmpexch (nullptr, scratch))
-      {
-	scratch->~hb_varc_scratch_t ();
-	hb_free (scratch);
-      }
+      scratch_pool.release (scratch, destroy_scratch);
+    }
+    static void destroy_scratch (hb_varc_scratch_t *scratch)
+    {
+      scratch->~hb_varc_scratch_t ();
+      hb_free (scratch);
     }
 
     private:
     hb_blob_ptr_t<VARC> table;
-    mutable hb_atomic_t<hb_varc_scratch_t *> cached_scratch;
+    hb_sharded_pool_t<hb_varc_scratch_t> scratch_pool;
   };
 
   bool has_data () const { return version.major != 0; }
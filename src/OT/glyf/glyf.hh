@@ -8,6 +8,7 @@
 #include "../../hb-ot-var-gvar-table.hh"
 #include "../../hb-draw.hh"
 #include "../../hb-paint.hh"
+#include "../../hb-sharded-pool.hh"
 
 #include "glyf-helpers.hh"
 #include "Glyph.hh"
@@ -204,12 +205,7 @@ struct glyf_accelerator_t
   }
   ~glyf_accelerator_t ()
   {
-    auto *scratch = cached_scratch.get_relaxed ();
-    if (scratch)
-    {
-      scratch->~hb_glyf_scratch_t ();
-      hb_free (scratch);
-    }
+    scratch_pool.clear (destroy_scratch);
 
     glyf_table.destroy ();
   }
@@ -491,27 +487,19 @@ struct glyf_accelerator_t
 
     hb_glyf_scratch_t *scratch;
 
-    // Borrow the cached strach buffer.
-    {
-      scratch = cached_scratch.get_acquire ();
-      if (!scratch || unlikely (!cached_scratch.cmpexch (scratch, nullptr)))
-      {
-	scratch = (hb_glyf_scratch_t *) hb_calloc (1, sizeof (hb_glyf_scratch_t));
-	if (unlikely (!scratch))
-	  return true;
-      }
-    }
+    // Borrow a cached scratch buffer.
+    scratch = scratch_pool.acquire ([] () {
+      return (hb_glyf_scratch_t *) hb_calloc (1, sizeof (hb_glyf_scratch_t));
+    });
+    if (unlikely (!scratch))
+      return true;
 
     bool ret = get_points (font, gid, glyf_impl::path_builder_t (font, draw_session),
 			   hb_array (font->coords, font->num_coords),
 			   *scratch);
 
     // Put it back.
-    if (!cached_scratch.cmpexch (nullptr, scratch))
-    {
-      scratch->~hb_glyf_scratch_t ();
-      hb_free (scratch);
-    }
+    scratch_pool.release (scratch, destroy_scratch);
 
     return ret;
   }
@@ -543,7 +531,12 @@ struct glyf_accelerator_t
   unsigned int num_glyphs;
   hb_blob_ptr_t<loca> loca_table;
   hb_blob_ptr_t<glyf> glyf_table;
-  mutable hb_atomic_t<hb_glyf_scratch_t *> cached_scratch;
+  static void destroy_scratch (hb_glyf_scratch_t *scratch)
+  {
+    scratch->~hb_glyf_scratch_t ();
+    hb_free (scratch);
+  }
+  hb_sharded_pool_t<hb_glyf_scratch_t> scratch_pool;
 };
 
 
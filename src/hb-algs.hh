@@ -978,6 +978,66 @@ hb_memcpy (void *__restrict dst, const void *__restrict src, size_t len)
   return memcpy (dst, src, len);
 }
 
+/* SipHash-2-4, by Jean-Philippe Aumasson and Daniel J. Bernstein; a keyed
+ * hash, for where, unlike fasthash, inputs may be crafted to collide.
+ * Input is read as 64-bit little-endian words.
+ * https://www.aumasson.jp/siphash/siphash.pdf */
+#define HB_SIPROUND(v0, v1, v2, v3) HB_STMT_START { \
+	v0 += v1; v1 = (v1 << 13) | (v1 >> 51); v1 ^= v0; v0 = (v0 << 32) | (v0 >> 32); \
+	v2 += v3; v3 = (v3 << 16) | (v3 >> 48); v3 ^= v2; \
+	v0 += v3; v3 = (v3 << 21) | (v3 >> 43); v3 ^= v0; \
+	v2 += v1; v1 = (v1 << 17) | (v1 >> 47); v1 ^= v2; v2 = (v2 << 32) | (v2 >> 32); \
+} HB_STMT_END
+
+static inline uint64_t hb_siphash24 (const void *buf, size_t len, uint64_t k0, uint64_t k1)
+{
+  const unsigned char *p = (const unsigned char *) buf;
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+  uint64_t b = (uint64_t) len << 56;
+
+  for (const unsigned char *end = p + (len & ~(size_t) 7); p != end; p += 8)
+  {
+    uint64_t m;
+#if defined(__BYTE_ORDER) && __BYTE_ORDER == __LITTLE_ENDIAN
+    hb_memcpy (&m, p, 8);
+#else
+    m = 0;
+    for (unsigned i = 0; i < 8; i++)
+      m |= (uint64_t) p[i] << (8 * i);
+#endif
+    v3 ^= m;
+    HB_SIPROUND (v0, v1, v2, v3);
+    HB_SIPROUND (v0, v1, v2, v3);
+    v0 ^= m;
+  }
+  switch (len & 7)
+  {
+    case 7: b |= (uint64_t) p[6] << 48; HB_FALLTHROUGH;
+    case 6: b |= (uint64_t) p[5] << 40; HB_FALLTHROUGH;
+    case 5: b |= (uint64_t) p[4] << 32; HB_FALLTHROUGH;
+    case 4: b |= (uint64_t) p[3] << 24; HB_FALLTHROUGH;
+    case 3: b |= (uint64_t) p[2] << 16; HB_FALLTHROUGH;
+    case 2: b |= (uint64_t) p[1] <<  8; HB_FALLTHROUGH;
+    case 1: b |= (uint64_t) p[0]; break;
+    case 0: break;
+  }
+
+  v3 ^= b;
+  HB_SIPROUND (v0, v1, v2, v3);
+  HB_SIPROUND (v0, v1, v2, v3);
+  v0 ^= b;
+  v2 ^= 0xff;
+  HB_SIPROUND (v0, v1, v2, v3);
+  HB_SIPROUND (v0, v1, v2, v3);
+  HB_SIPROUND (v0, v1, v2, v3);
+  HB_SIPROUND (v0, v1, v2, v3);
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+#undef HB_SIPROUND
+
 static inline int
 hb_memcmp (const void *a, const void *b, unsigned int len)
 {
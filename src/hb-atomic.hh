@@ -175,6 +175,7 @@ struct hb_atomic_t
   T get_acquire () const { return hb_atomic_int_impl_get (&v); }
   T inc () { return hb_atomic_int_impl_add (&v,  1); }
   T dec () { return hb_atomic_int_impl_add (&v, -1); }
+  T add (T d) { return hb_atomic_int_impl_add (&v, d); }
 
   int operator ++ (int) { return inc (); }
   int operator -- (int) { return dec (); }
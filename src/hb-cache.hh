@@ -109,4 +109,134 @@ struct hb_cache_t
 };
 
 
+/* Like hb_cache_t, but with the number of cache slots chosen at runtime.
+ *
+ * The fixed 256-slot hb_cache_t thrashes on fonts with tens of thousands
+ * of glyphs in use (eg. CJK); this variant lets the owner size the cache
+ * for the font at hand.  Items are always 32-bit, which bounds how few
+ * slots there can be: the high key bits not covered by the slot index
+ * must fit next to the value.
+ *
+ * Allocate with create() and free with destroy(); the slots follow the
+ * struct in the same allocation.
+ */
+
+template <unsigned int key_bits,
+	  unsigned int value_bits,
+	  bool thread_safe=true>
+struct hb_sized_cache_t
+{
+  using item_t = typename std::conditional<thread_safe,
+					   hb_atomic_t<unsigned int>,
+					   unsigned int>::type;
+
+  static constexpr unsigned MIN_CACHE_BITS = key_bits + value_bits > 32 ? key_bits + value_bits - 32 : 0;
+  static constexpr unsigned MAX_CACHE_BITS = key_bits < 16 ? key_bits : 16;
+  static_assert ((MIN_CACHE_BITS <= MAX_CACHE_BITS), "");
+
+  static unsigned clamp_bits (unsigned cache_bits)
+  {
+    if (cache_bits < MIN_CACHE_BITS) return MIN_CACHE_BITS;
+    if (cache_bits > MAX_CACHE_BITS) return MAX_CACHE_BITS;
+    return cache_bits;
+  }
+
+  static hb_sized_cache_t *create (unsigned cache_bits)
+  {
+    cache_bits = clamp_bits (cache_bits);
+    size_t size = sizeof (hb_sized_cache_t) + ((1u << cache_bits) - 1) * sizeof (item_t);
+    hb_sized_cache_t *cache = (hb_sized_cache_t *) hb_malloc (size);
+    if (unlikely (!cache))
+      return nullptr;
+    cache->cache_bits = cache_bits;
+    cache->clear ();
+    return cache;
+  }
+  static void destroy (hb_sized_cache_t *cache) { hb_free (cache); }
+
+  unsigned get_cache_bits () const { return cache_bits; }
+
+  void clear ()
+  {
+    unsigned count = 1u << cache_bits;
+    for (unsigned i = 0; i < count; i++)
+      values[i] = -1;
+  }
+
+  bool get (unsigned int key, unsigned int *value) const
+  {
+    unsigned int k = key & ((1u<<cache_bits)-1);
+    unsigned int v = values[k];
+    /* All-ones is the empty marker; an item that happens to encode it
+     * just reads as a miss. */
+    if (v == (unsigned int) -1 ||
+	(v >> value_bits) != (key >> cache_bits))
+      return false;
+    *value = v & ((1u<<value_bits)-1);
+    return true;
+  }
+
+  bool set (unsigned int key, unsigned int value)
+  {
+    if (unlikely ((key >> key_bits) || (value >> value_bits)))
+      return false; /* Overflows */
+    unsigned int k = key & ((1u<<cache_bits)-1);
+    unsigned int v = ((key>>cache_bits)<<value_bits) | value;
+    values[k] = v;
+    return true;
+  }
+
+  private:
+  unsigned cache_bits;
+  item_t values[1]; /* Actually 1 << cache_bits. */
+};
+
+
+/* Size, as log2 of the number of slots, of a cache of per-glyph data
+ * for a font of num_glyphs glyphs: 256 slots for fonts of up to 4096
+ * glyphs, then one slot per 16 glyphs, up to max_bits. */
+static inline unsigned
+hb_glyph_cache_bits (unsigned num_glyphs, unsigned max_bits)
+{
+  unsigned bits = num_glyphs > 1 ? hb_bit_storage (num_glyphs - 1) : 0;
+  bits = bits > 4 ? bits - 4 : 0;
+  return hb_clamp (bits, 8u, max_bits);
+}
+
+
+/* An intrusive doubly-linked list, kept in most-recently-used order, for
+ * the bookkeeping of LRU caches.  Type must have prev and next pointers
+ * to Type.  Not thread-safe; callers serialize access themselves. */
+template <typename Type>
+struct hb_lru_list_t
+{
+  void push_front (Type *item)
+  {
+    item->prev = nullptr;
+    item->next = head;
+    if (head)
+      head->prev = item;
+    head = item;
+    if (!tail)
+      tail = item;
+  }
+  void remove (Type *item)
+  {
+    if (item->prev) item->prev->next = item->next; else head = item->next;
+    if (item->next) item->next->prev = item->prev; else tail = item->prev;
+    item->prev = item->next = nullptr;
+  }
+  void move_to_front (Type *item)
+  {
+    if (item == head)
+      return;
+    remove (item);
+    push_front (item);
+  }
+
+  Type *head = nullptr; /* Most-recently-used. */
+  Type *tail = nullptr; /* Least-recently-used. */
+};
+
+
 #endif /* HB_CACHE_HH */
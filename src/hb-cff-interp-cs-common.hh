@@ -896,10 +896,245 @@ struct cs_interpreter_t : interpreter_t<ENV>
     return true;
   }
 
+  /* Like interpret(), but also records the charstring, with all
+   * subroutine calls inlined and returns dropped, to flat.  Returns
+   * the number of subroutine calls inlined in num_calls.  flat is
+   * cleared if the charstring cannot be flattened, ie. if a
+   * subroutine number is not a literal right before the call. */
+  bool interpret_flattening (PARAM& param,
+			     hb_vector_t<unsigned char> &flat,
+			     unsigned &num_calls)
+  {
+    ENV &env = SUPER::env;
+    env.set_endchar (false);
+
+    bool flattening = true;
+    unsigned last_number_start = (unsigned) -1;
+    num_calls = 0;
+
+    unsigned max_ops = HB_CFF_MAX_OPS;
+    for (;;) {
+      hb_ubytes_t head = env.str_ref;
+      unsigned start = env.str_ref.get_offset ();
+
+      op_code_t op = env.fetch_op ();
+      OPSET::process_op (op, env, param);
+      if (unlikely (env.in_error () || !--max_ops))
+      {
+	env.set_error ();
+	flat.resize (0);
+	return false;
+      }
+
+      if (flattening)
+      {
+	switch (op)
+	{
+	  case OpCode_callsubr:
+	  case OpCode_callgsubr:
+	    /* Drop the subroutine number. */
+	    if (unlikely (last_number_start == (unsigned) -1))
+	    {
+	      flattening = false;
+	      break;
+	    }
+	    flat.shrink (last_number_start, false);
+	    last_number_start = (unsigned) -1;
+	    num_calls++;
+	    break;
+
+	  case OpCode_return:
+	    break;
+
+	  default:
+	  {
+	    bool is_number = op == OpCode_shortint ||
+			     (OpCode_OneByteIntFirst <= op && op <= OpCode_fixedcs);
+	    last_number_start = is_number ? flat.length : (unsigned) -1;
+	    flat.extend (head.sub_array (0, env.str_ref.get_offset () - start));
+	    if (unlikely (flat.in_error () || flat.length > HB_CFF_MAX_FLAT_CHARSTRING_LENGTH))
+	      flattening = false;
+	  }
+	}
+      }
+
+      if (env.is_endchar ())
+	break;
+    }
+
+    if (!flattening)
+      flat.resize (0);
+    return true;
+  }
+
   private:
   typedef interpreter_t<ENV> SUPER;
 };
 
+
+#ifndef HB_CFF_CHARSTRING_CACHE_MAX_BYTES
+#define HB_CFF_CHARSTRING_CACHE_MAX_BYTES (4u << 20)
+#endif
+
+/* A per-face cache of flattened charstrings, ie. charstrings with all
+ * subroutine calls inlined.  Drawing a glyph, or measuring its extents,
+ * again then does not need to look subroutines up in their INDEXes and
+ * maintain the call stack.  Glyphs whose charstrings do not call
+ * subroutines, or cannot be flattened, are remembered as such, and
+ * interpreted from the font data.
+ *
+ * Entries are published through an array of atomic per-glyph slots,
+ * allocated on first insertion, so neither lookups nor insertions take
+ * a lock.  Once the memory budget is used up, further glyphs are not
+ * flattened anymore; evicting instead would make scans over more glyphs
+ * than fit pay for flattening on every draw.  Entries are never freed
+ * before the face is trimmed or destroyed, so they can be used as is. */
+struct cs_flat_cache_t
+{
+  typedef hb_vector_t<unsigned char> flat_t;
+
+  /* The charstring to interpret for a glyph. */
+  struct lookup_t
+  {
+    lookup_t (const cs_flat_cache_t *cache_,
+	      hb_codepoint_t glyph_,
+	      const hb_ubytes_t &str_) :
+      cache (const_cast<cs_flat_cache_t *> (cache_)), glyph (glyph_), str (str_)
+    {
+      if (!cache)
+	return;
+      const flat_t *flat;
+      if (cache->get (glyph, &flat))
+      {
+	if (flat)
+	  str = flat->as_array ();
+	cache = nullptr;
+      }
+      else if (cache->is_full ())
+	cache = nullptr;
+    }
+
+    /* Interprets str, flattening it on a cache miss. */
+    template <typename INTERP, typename PARAM>
+    bool interpret (INTERP &interp, PARAM &param)
+    {
+      if (!cache)
+	return interp.interpret (param);
+
+      flat_t flat;
+      unsigned num_calls;
+      bool ret = interp.interpret_flattening (param, flat, num_calls);
+      cache->insert (glyph, ret && num_calls ? &flat : nullptr);
+      return ret;
+    }
+
+    cs_flat_cache_t *cache;
+    hb_codepoint_t glyph;
+    hb_ubytes_t str;
+  };
+
+  ~cs_flat_cache_t () { clear (); }
+
+  void init (unsigned num_glyphs_) { num_glyphs = num_glyphs_; }
+
+  /* Frees all entries.  Must not run concurrently with any user of
+   * the cache, as entries are used without synchronization. */
+  void clear ()
+  {
+    hb_atomic_t<flat_t *> *slots = this->slots.get_relaxed ();
+    if (slots)
+    {
+      for (unsigned i = 0; i < num_glyphs; i++)
+	destroy (slots[i].get_relaxed ());
+      hb_free (slots);
+      this->slots.set_relaxed (nullptr);
+    }
+    memory.set_relaxed (0);
+  }
+
+  unsigned get_memory_usage () const { return memory.get_relaxed (); }
+
+  /* Sets *flat to nullptr if the original charstring is to be used. */
+  bool get (hb_codepoint_t glyph, const flat_t **flat) const
+  {
+    hb_atomic_t<flat_t *> *slots = this->slots.get_acquire ();
+    if (!slots || glyph >= num_glyphs)
+      return false;
+    flat_t *v = slots[glyph].get_acquire ();
+    if (!v)
+      return false;
+    *flat = v == use_original () ? nullptr : v;
+    return true;
+  }
+
+  bool is_full () const { return memory.get_relaxed () >= HB_CFF_CHARSTRING_CACHE_MAX_BYTES; }
+
+  /* Takes over the contents of flat; nullptr to use the original. */
+  void insert (hb_codepoint_t glyph, flat_t *flat)
+  {
+    if (unlikely (glyph >= num_glyphs))
+      return;
+
+    hb_atomic_t<flat_t *> *slots = this->slots.get_acquire ();
+    if (!slots)
+    {
+      slots = (hb_atomic_t<flat_t *> *) hb_calloc (num_glyphs, sizeof (slots[0]));
+      if (unlikely (!slots))
+	return;
+      if (this->slots.cmpexch (nullptr, slots))
+	memory.add (num_glyphs * sizeof (slots[0]));
+      else
+      {
+	hb_free (slots);
+	slots = this->slots.get_acquire ();
+	if (unlikely (!slots))
+	  return;
+      }
+    }
+
+    flat_t *v = use_original ();
+    unsigned size = 0;
+    if (flat && flat->length)
+    {
+      v = (flat_t *) hb_calloc (1, sizeof (flat_t));
+      if (unlikely (!v))
+	return;
+      new (v) flat_t ();
+      if (unlikely (!v->alloc_exact (flat->length)))
+      {
+	destroy (v);
+	return;
+      }
+      v->extend (flat->as_array ());
+      size = sizeof (*v) + v->length;
+    }
+
+    if (!slots[glyph].cmpexch (nullptr, v))
+    {
+      /* Another thread beat us to it. */
+      destroy (v);
+      return;
+    }
+    memory.add (size);
+  }
+
+  private:
+  /* Marks glyphs whose original charstring is to be used. */
+  static flat_t *use_original () { return const_cast<flat_t *> (&Null (flat_t)); }
+
+  static void destroy (flat_t *v)
+  {
+    if (!v || v == use_original ())
+      return;
+    v->~flat_t ();
+    hb_free (v);
+  }
+
+  hb_atomic_t<hb_atomic_t<flat_t *> *> slots;
+  unsigned num_glyphs = 0;
+  hb_atomic_t<unsigned> memory;
+};
+
 } /* namespace CFF */
 
 #endif /* HB_CFF_INTERP_CS_COMMON_HH */
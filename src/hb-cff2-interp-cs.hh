@@ -72,7 +72,7 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<ELEM, CFF2Subrs>
   cff2_cs_interp_env_t (const hb_ubytes_t &str, ACC &acc, unsigned int fd,
 			const int *coords_=nullptr, unsigned int num_coords_=0)
     : SUPER (str, acc.globalSubrs, acc.privateDicts[fd].localSubrs),
-      cached_scalars_vector (&acc.cached_scalars_vector)
+      cached_region_scalars (&acc.cached_region_scalars)
   {
     coords = coords_;
     num_coords = num_coords_;
@@ -83,36 +83,27 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<ELEM, CFF2Subrs>
 
   ~cff2_cs_interp_env_t ()
   {
-    release_scalars_vector (scalars);
+    release_region_scalars ();
   }
 
-  hb_vector_t<float> *acquire_scalars_vector () const
+  cff2_region_scalars_t *acquire_region_scalars () const
   {
-    hb_vector_t<float> *scalars = cached_scalars_vector->get_acquire ();
+    cff2_region_scalars_t *region_scalars = cached_region_scalars->get_acquire ();
 
-    if (!scalars || !cached_scalars_vector->cmpexch (scalars, nullptr))
-    {
-      scalars = (hb_vector_t<float> *) hb_calloc (1, sizeof (hb_vector_t<float>));
-      if (unlikely (!scalars))
-	return nullptr;
-      scalars->init ();
-    }
+    if (!region_scalars || !cached_region_scalars->cmpexch (region_scalars, nullptr))
+      region_scalars = cff2_region_scalars_t::create ();
 
-    return scalars;
+    return region_scalars;
   }
 
-  void release_scalars_vector (hb_vector_t<float> *scalars) const
+  void release_region_scalars ()
   {
-    if (!scalars)
+    if (!region_scalars)
       return;
 
-    scalars->clear ();
-
-    if (!cached_scalars_vector->cmpexch (nullptr, scalars))
-    {
-      scalars->fini ();
-      hb_free (scalars);
-    }
+    if (!cached_region_scalars->cmpexch (nullptr, region_scalars))
+      cff2_region_scalars_t::destroy (region_scalars);
+    region_scalars = nullptr;
     scalars = nullptr;
   }
 
@@ -142,20 +133,16 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<ELEM, CFF2Subrs>
   {
     if (!seen_blend)
     {
-      scalars = acquire_scalars_vector ();
-      if (unlikely (!scalars))
-	SUPER::set_error ();
-      else
+      region_count = varStore->varStore.get_region_index_count (get_ivs ());
+      if (do_blend)
       {
-	region_count = varStore->varStore.get_region_index_count (get_ivs ());
-	if (do_blend)
-	{
-	  if (unlikely (!scalars->resize_exact (region_count)))
-	    SUPER::set_error ();
-	  else
-	    varStore->varStore.get_region_scalars (get_ivs (), coords, num_coords,
-						   &(*scalars)[0], region_count);
-	}
+	/* The scalars only depend on the coordinates and vsindex; they are
+	 * kept on the accelerator and shared by subsequent charstrings. */
+	region_scalars = acquire_region_scalars ();
+	if (likely (region_scalars))
+	  scalars = region_scalars->get (*varStore, get_ivs (), coords, num_coords);
+	if (unlikely (!scalars))
+	  SUPER::set_error ();
       }
       seen_blend = true;
     }
@@ -196,6 +183,30 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<ELEM, CFF2Subrs>
     return v;
   }
 
+  /* Blends a block of values at once; deltas holds the region deltas of
+   * each value in turn.  Each value sums its deltas in region order, such
+   * that results match blend_deltas() exactly. */
+  void blend_values (hb_array_t<ELEM> values, hb_array_t<const ELEM> deltas) const
+  {
+    if (!do_blend || unlikely (!scalars))
+      return;
+
+    unsigned count = values.length;
+    unsigned k = scalars->length;
+    if (unlikely (deltas.length != count * k))
+      return;
+
+    const float *s = scalars->arrayZ;
+    const ELEM *d = deltas.arrayZ;
+    for (unsigned i = 0; i < count; i++, d += k)
+    {
+      double v = 0;
+      for (unsigned j = 0; j < k; j++)
+	v += (double) s[j] * d[j].to_real ();
+      values.arrayZ[i].set_real (values.arrayZ[i].to_real () + v);
+    }
+  }
+
   bool have_coords () const { return num_coords; }
 
   protected:
@@ -204,8 +215,9 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<ELEM, CFF2Subrs>
   const	 CFF2ItemVariationStore *varStore;
   unsigned int  region_count;
   unsigned int  ivs;
-  hb_vector_t<float>  *scalars = nullptr;
-  hb_atomic_t<hb_vector_t<float> *> *cached_scalars_vector = nullptr;
+  const hb_vector_t<float>  *scalars = nullptr;
+  cff2_region_scalars_t  *region_scalars = nullptr;
+  hb_atomic_t<cff2_region_scalars_t *> *cached_region_scalars = nullptr;
   bool	  do_blend;
   bool	  seen_vsindex_ = false;
   bool	  seen_blend = false;
@@ -263,14 +275,27 @@ struct cff2_cs_opset_t : cs_opset_t<ELEM, OPSET, cff2_cs_interp_env_t<ELEM>, PAR
     else
       arg.set_blends (n, i, blends);
   }
+
+  template <typename T = ELEM,
+	    hb_enable_if (hb_is_same (T, blend_arg_t))>
+  static void process_args_blend (cff2_cs_interp_env_t<ELEM> &env,
+				  unsigned start, unsigned n, unsigned k)
+  {
+    for (unsigned int i = 0; i < n; i++)
+    {
+      const hb_array_t<const ELEM> blends = env.argStack.sub_array (start + n + (i * k), k);
+      process_arg_blend (env, env.argStack[start + i], blends, n, i);
+    }
+  }
   template <typename T = ELEM,
 	    hb_enable_if (!hb_is_same (T, blend_arg_t))>
-  static void process_arg_blend (cff2_cs_interp_env_t<ELEM> &env,
-				 ELEM &arg,
-				 const hb_array_t<const ELEM> blends,
-				 unsigned n, unsigned i)
+  static void process_args_blend (cff2_cs_interp_env_t<ELEM> &env,
+				  unsigned start, unsigned n, unsigned k)
   {
-    arg.set_real (arg.to_real () + env.blend_deltas (blends));
+    if (!n)
+      return;
+    env.blend_values (hb_array_t<ELEM> (&env.argStack[start], n),
+		      env.argStack.sub_array (start + n, n * k));
   }
 
   static void process_blend (cff2_cs_interp_env_t<ELEM> &env, PARAM& param)
@@ -288,11 +313,7 @@ struct cff2_cs_opset_t : cs_opset_t<ELEM, OPSET, cff2_cs_interp_env_t<ELEM>, PAR
       env.set_error ();
       return;
     }
-    for (unsigned int i = 0; i < n; i++)
-    {
-      const hb_array_t<const ELEM> blends = env.argStack.sub_array (start + n + (i * k), k);
-      process_arg_blend (env, env.argStack[start + i], blends, n, i);
-    }
+    process_args_blend (env, start, n, k);
 
     /* pop off blend values leaving default values now adorned with blend values */
     env.argStack.pop (k * n);
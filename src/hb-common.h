@@ -377,6 +377,37 @@ typedef struct hb_user_data_key_t {
  */
 typedef void (*hb_destroy_func_t) (void *user_data);
 
+/**
+ * hb_task_func_t:
+ * @task_data: the data passed to the executor along with this function
+ * @index: the index of the task to run
+ *
+ * A unit of work handed to an #hb_executor_func_t.  Tasks of the same
+ * batch are independent of each other and may run concurrently.
+ *
+ * Since: REPLACEME
+ */
+typedef void (*hb_task_func_t) (void *task_data, unsigned int index);
+
+/**
+ * hb_executor_func_t:
+ * @func: the task function to run
+ * @task_data: the data to pass to @func
+ * @num_tasks: the number of tasks to run
+ * @user_data: user data pointer passed by the caller
+ *
+ * A virtual method for running a batch of tasks, for example on a thread
+ * pool.  The executor must call @func once with each index from zero to
+ * @num_tasks - 1, in any order and on any threads, and only return once
+ * all of them have finished.
+ *
+ * Since: REPLACEME
+ */
+typedef void (*hb_executor_func_t) (hb_task_func_t  func,
+				    void           *task_data,
+				    unsigned int    num_tasks,
+				    void           *user_data);
+
 
 /* Font features and variations. */
 
@@ -192,7 +192,11 @@
 #ifdef HB_MINIMIZE_MEMORY_USAGE
 #define HB_NO_GDEF_CACHE
 #define HB_NO_OT_LAYOUT_LOOKUP_CACHE
+#define HB_NO_OT_LAYOUT_COVERAGE_BITMAP
 #define HB_NO_OT_FONT_CMAP_CACHE
+#define HB_NO_OT_FONT_CMAP_DIRECT_MAP
+#define HB_NO_OT_FONT_EXTENTS_CACHE
+#define HB_NO_CFF_CHARSTRING_CACHE
 #endif
 
 #ifdef HB_OPTIMIZE_SIZE
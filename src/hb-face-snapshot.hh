@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Google Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_FACE_SNAPSHOT_HH
+#define HB_FACE_SNAPSHOT_HH
+
+#include "hb.hh"
+
+#include "hb-blob.hh"
+#include "hb-set-digest.hh"
+
+
+/* Layout of the accelerator snapshots written by
+ * hb_face_serialize_accelerators().
+ *
+ * A snapshot is only ever read by the same build that wrote it, so
+ * everything is in native byte order and the structs are used in place;
+ * offsets are 8-byte aligned so a snapshot mmapped from a file can be
+ * attached without copying.  hb_face_attach_accelerators() checks the
+ * header, the bounds of every section, and that each section was made
+ * from the very same table bytes, before any of it is used.
+ *
+ * Nothing in a snapshot is trusted for memory safety: it only holds
+ * glyph ids and coverage filters, which the users range-check or use
+ * as hints. */
+
+#define HB_FACE_SNAPSHOT_MAGIC		HB_TAG ('h','b','a','s')
+#define HB_FACE_SNAPSHOT_VERSION	1u
+#define HB_FACE_SNAPSHOT_BYTE_ORDER	0x01020304u
+
+struct hb_face_snapshot_header_t
+{
+  hb_tag_t magic;		/* HB_FACE_SNAPSHOT_MAGIC. */
+  uint32_t version;		/* HB_FACE_SNAPSHOT_VERSION. */
+  uint32_t byte_order;		/* HB_FACE_SNAPSHOT_BYTE_ORDER. */
+  uint32_t hb_version;		/* Library version that wrote it. */
+  uint32_t digest_size;		/* sizeof (hb_set_digest_t). */
+  uint32_t num_glyphs;		/* Glyph count of the face. */
+  uint32_t section_count;
+  uint32_t reserved;
+  /* Followed by section_count hb_face_snapshot_section_t. */
+};
+
+struct hb_face_snapshot_section_t
+{
+  hb_tag_t tag;			/* Table the section was built from. */
+  uint32_t offset;		/* From start of snapshot; 8-byte aligned. */
+  uint32_t length;
+  uint32_t reserved;
+  uint64_t table_digest;	/* hb_face_snapshot_table_digest() of the table. */
+};
+
+/* 'GSUB' and 'GPOS' sections: per-subtable coverage filters of every
+ * lookup, as built by hb_ot_layout_lookup_accelerator_t. */
+struct hb_face_snapshot_lookups_t
+{
+  uint32_t lookup_count;
+  uint32_t subtable_count;
+  uint32_t first_subtable[HB_VAR_ARRAY]; /* lookup_count + 1 entries. */
+  /* Followed by subtable_count hb_face_snapshot_subtable_t, 8-byte aligned. */
+
+  static unsigned get_subtables_offset (unsigned lookup_count)
+  { return (sizeof (uint32_t) * (2 + lookup_count + 1) + 7) & ~7u; }
+};
+
+struct hb_face_snapshot_subtable_t
+{
+  hb_set_digest_t digest;
+  uint32_t bitmap_first;	/* First glyph of the coverage bitmap. */
+  uint32_t bitmap_length;	/* In glyphs; zero if no bitmap. */
+  uint32_t bitmap_offset;	/* Of the bitmap words, from start of section. */
+  uint32_t reserved;
+};
+
+/* 'post' section: glyph ids sorted by glyph name. */
+struct hb_face_snapshot_glyph_names_t
+{
+  uint32_t count;
+  uint16_t gids[HB_VAR_ARRAY];
+};
+
+static inline uint64_t
+hb_face_snapshot_table_digest (hb_face_t *face, hb_tag_t tag)
+{
+  hb_blob_t *blob = hb_face_reference_table (face, tag);
+  uint64_t digest = fasthash64 (blob->data, blob->length, tag);
+  hb_blob_destroy (blob);
+  return digest;
+}
+
+
+#endif /* HB_FACE_SNAPSHOT_HH */
@@ -32,6 +32,7 @@
 #include "hb-blob.hh"
 #include "hb-open-file.hh"
 #include "hb-ot-face.hh"
+#include "hb-face-snapshot.hh"
 #include "hb-ot-cmap-table.hh"
 
 #ifdef HAVE_FREETYPE
@@ -580,13 +581,7 @@ hb_face_destroy (hb_face_t *face)
   if (!hb_object_destroy (face)) return;
 
 #ifndef HB_NO_SHAPER
-  for (hb_face_t::plan_node_t *node = face->shape_plans; node; )
-  {
-    hb_face_t::plan_node_t *next = node->next;
-    hb_shape_plan_destroy (node->shape_plan);
-    hb_free (node);
-    node = next;
-  }
+  hb_shape_plan_cache_t::destroy (face->shape_plans);
 #endif
 
   face->data.fini ();
@@ -595,6 +590,11 @@ hb_face_destroy (hb_face_t *face)
   if (face->get_table_tags_destroy)
     face->get_table_tags_destroy (face->get_table_tags_user_data);
 
+  if (face->sanitize_cache_destroy)
+    face->sanitize_cache_destroy (face->sanitize_cache_user_data);
+
+  hb_blob_destroy (face->snapshot);
+
   if (face->destroy)
     face->destroy (face->user_data);
 
@@ -872,6 +872,280 @@ hb_face_get_glyph_count (const hb_face_t *face)
   return face->get_num_glyphs ();
 }
 
+/**
+ * hb_face_warmup:
+ * @face: A face object
+ * @table_tags: (array length=table_count) (nullable): Tags of the tables to load
+ * @table_count: Number of tags in @table_tags
+ * @executor: (nullable): Executor to run the loading tasks with
+ * @executor_data: User data to pass to @executor
+ *
+ * Loads and sanitizes the tables of @face with the given tags, and builds
+ * their accelerators, ahead of use.  Otherwise, this happens lazily, one
+ * table after another, the first time each table is needed, eg. during the
+ * first shaping call with @face; for large fonts, that can take long.
+ *
+ * If @table_tags is `NULL`, the tables used by shaping and by the built-in
+ * font functions are loaded.  Tags of tables HarfBuzz does not load itself,
+ * or that @face does not have, are ignored.
+ *
+ * Each table is loaded by a separate task, and the tasks are handed to
+ * @executor in one batch, such that they can run concurrently.  If
+ * @executor is `NULL`, the tables are loaded on the calling thread.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_warmup (hb_face_t          *face,
+		const hb_tag_t     *table_tags,
+		unsigned int        table_count,
+		hb_executor_func_t  executor,
+		void               *executor_data)
+{
+  if (unlikely (!hb_object_is_valid (face)))
+    return;
+
+  face->table.warm_up (table_tags, table_count, executor, executor_data);
+}
+
+/**
+ * hb_face_serialize_accelerators:
+ * @face: A face object
+ *
+ * Builds the accelerators of @face that can be saved, and serializes
+ * them into a blob that hb_face_attach_accelerators() can later attach
+ * to a face made from the same font data, in this or another process,
+ * so that it does not need to build them again.
+ *
+ * The snapshot currently holds the glyph coverage filters of all
+ * `GSUB` and `GPOS` lookups and the glyph-name index of the `post`
+ * table.  It is in native byte order and is only valid for the same
+ * HarfBuzz version; it is meant to be cached on local disk, not
+ * distributed.
+ *
+ * Return value: (transfer full): The snapshot, or the empty blob on failure
+ *
+ * Since: REPLACEME
+ **/
+hb_blob_t *
+hb_face_serialize_accelerators (hb_face_t *face)
+{
+  if (unlikely (!hb_object_is_valid (face)))
+    return hb_blob_get_empty ();
+
+  return face->table.serialize_accelerators ();
+}
+
+static bool
+_hb_face_snapshot_section_is_valid (const hb_face_snapshot_section_t &section,
+				    const char *data)
+{
+  switch (section.tag)
+  {
+    case HB_TAG ('G','S','U','B'):
+    case HB_TAG ('G','P','O','S'):
+    {
+      auto *lookups = (const hb_face_snapshot_lookups_t *) (const void *) data;
+      if (section.length < 2 * sizeof (uint32_t) ||
+	  lookups->lookup_count > (section.length / sizeof (uint32_t)))
+	return false;
+      unsigned subtables_offset = hb_face_snapshot_lookups_t::get_subtables_offset (lookups->lookup_count);
+      if (subtables_offset > section.length ||
+	  lookups->subtable_count > (section.length - subtables_offset) / sizeof (hb_face_snapshot_subtable_t))
+	return false;
+      for (unsigned i = 0; i < lookups->lookup_count; i++)
+	if (lookups->first_subtable[i] > lookups->first_subtable[i + 1])
+	  return false;
+      if (lookups->first_subtable[0] || lookups->first_subtable[lookups->lookup_count] != lookups->subtable_count)
+	return false;
+
+      auto *subtables = (const hb_face_snapshot_subtable_t *) (const void *) (data + subtables_offset);
+      for (unsigned i = 0; i < lookups->subtable_count; i++)
+      {
+	const auto &subtable = subtables[i];
+	if (!subtable.bitmap_length)
+	  continue;
+	uint64_t size = ((uint64_t) subtable.bitmap_length + 63) / 64 * sizeof (uint64_t);
+	if (subtable.bitmap_offset % sizeof (uint64_t) ||
+	    subtable.bitmap_offset + size > section.length)
+	  return false;
+      }
+      return true;
+    }
+
+    case HB_TAG ('p','o','s','t'):
+    {
+      auto *names = (const hb_face_snapshot_glyph_names_t *) (const void *) data;
+      return section.length >= sizeof (uint32_t) &&
+	     names->count <= (section.length - sizeof (uint32_t)) / sizeof (uint16_t);
+    }
+
+    default:
+      /* From a newer minor revision; ignored. */
+      return true;
+  }
+}
+
+/**
+ * hb_face_attach_accelerators:
+ * @face: A face object
+ * @blob: A snapshot from hb_face_serialize_accelerators()
+ *
+ * Attaches a snapshot of accelerators made by
+ * hb_face_serialize_accelerators() to @face.  The snapshot is used in
+ * place, without copying, so a blob from hb_blob_create_from_file(),
+ * which maps the file into memory where possible, makes this nearly
+ * free.  @face keeps a reference to @blob.
+ *
+ * The snapshot is checked against the HarfBuzz version and against
+ * the data of the tables it was built from; a stale or mismatching
+ * snapshot is rejected.  Attach the snapshot before using @face;
+ * accelerators that were already built are not affected.
+ *
+ * Return value: `true` if the snapshot was attached, `false` otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_face_attach_accelerators (hb_face_t *face,
+			     hb_blob_t *blob)
+{
+  if (hb_object_is_immutable (face) || face->snapshot)
+    return false;
+
+  const char *data = blob->data;
+  unsigned length = blob->length;
+  auto *header = (const hb_face_snapshot_header_t *) (const void *) data;
+  if (length < sizeof (*header) ||
+      (uintptr_t) data % alignof (uint64_t) ||
+      header->magic != HB_FACE_SNAPSHOT_MAGIC ||
+      header->version != HB_FACE_SNAPSHOT_VERSION ||
+      header->byte_order != HB_FACE_SNAPSHOT_BYTE_ORDER ||
+      header->hb_version != (HB_VERSION_MAJOR << 16 | HB_VERSION_MINOR << 8 | HB_VERSION_MICRO) ||
+      header->digest_size != sizeof (hb_set_digest_t) ||
+      header->num_glyphs != face->get_num_glyphs () ||
+      header->section_count > (length - sizeof (*header)) / sizeof (hb_face_snapshot_section_t))
+    return false;
+
+  auto *sections = (const hb_face_snapshot_section_t *) (const void *) (data + sizeof (*header));
+  for (unsigned i = 0; i < header->section_count; i++)
+  {
+    const auto &section = sections[i];
+    if (section.offset % alignof (uint64_t) ||
+	section.offset > length ||
+	section.length > length - section.offset ||
+	section.table_digest != hb_face_snapshot_table_digest (face, section.tag) ||
+	!_hb_face_snapshot_section_is_valid (section, data + section.offset))
+      return false;
+  }
+
+  hb_blob_make_immutable (blob);
+  face->snapshot = hb_blob_reference (blob);
+  return true;
+}
+
+/**
+ * hb_face_get_memory_usage:
+ * @face: A face object
+ * @start_offset: The index of the first entry to retrieve
+ * @entry_count: (inout) (optional): Input = the maximum number of entries to return;
+ *               Output = the actual number of entries returned (may be zero)
+ * @tags: (out) (array length=entry_count) (optional): The tags of the entries
+ * @sizes: (out) (array length=entry_count) (optional): The sizes of the entries, in bytes
+ *
+ * Fetches how much heap memory @face uses, broken down by table.
+ *
+ * There is one entry for each table that has been loaded so far, with
+ * the memory used by its accelerator and caches, plus a first entry
+ * tagged #HB_TAG_NONE for the face object itself and its shape-plan
+ * cache.  Font data that the tables point into is not counted, and
+ * neither are fonts created on @face.  Sizes are close estimates.
+ *
+ * Return value: Total number of entries
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_face_get_memory_usage (const hb_face_t *face,
+			  unsigned int     start_offset,
+			  unsigned int    *entry_count, /* IN/OUT */
+			  hb_tag_t        *tags,        /* OUT */
+			  unsigned int    *sizes        /* OUT */)
+{
+  hb_vector_t<hb_pair_t<hb_tag_t, unsigned>> entries;
+
+  unsigned size = sizeof (*face);
+#ifndef HB_NO_SHAPER
+  hb_shape_plan_cache_t *shape_plans = face->shape_plans.get_acquire ();
+  if (shape_plans)
+    size += shape_plans->get_memory_usage ();
+#endif
+  entries.push (hb_pair (HB_TAG_NONE, size));
+
+  if (hb_object_is_valid (face))
+    face->table.get_memory_usage (entries);
+
+  if (entry_count)
+  {
+    auto out = entries.as_array ().sub_array (start_offset, entry_count);
+    for (unsigned i = 0; i < out.length; i++)
+    {
+      if (tags) tags[i] = out[i].first;
+      if (sizes) sizes[i] = out[i].second;
+    }
+  }
+
+  return entries.length;
+}
+
+/**
+ * hb_face_trim:
+ * @face: A face object
+ *
+ * Frees the memory @face uses for things it can rebuild on demand: the
+ * shape-plan cache, the `GSUB` and `GPOS` lookup accelerators, glyph-name
+ * indexes, and flattened `CFF` charstrings.  Tables and their core
+ * accelerators stay loaded.
+ *
+ * This is meant to be called under memory pressure, at a point where
+ * @face is idle: it must not be called while @face, or any font created
+ * on it, is in use in another thread.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_trim (hb_face_t *face)
+{
+  if (unlikely (!hb_object_is_valid (face)))
+    return;
+
+#ifndef HB_NO_SHAPER
+  hb_shape_plan_cache_t *shape_plans = face->shape_plans.get_acquire ();
+  if (shape_plans)
+    shape_plans->trim ();
+#endif
+
+  face->table.trim ();
+}
+
+const void *
+hb_face_t::get_snapshot_section (hb_tag_t tag, unsigned *length) const
+{
+  *length = 0;
+  if (likely (!snapshot))
+    return nullptr;
+
+  auto *header = (const hb_face_snapshot_header_t *) (const void *) snapshot->data;
+  auto *sections = (const hb_face_snapshot_section_t *) (const void *) (snapshot->data + sizeof (*header));
+  for (unsigned i = 0; i < header->section_count; i++)
+    if (sections[i].tag == tag)
+    {
+      *length = sections[i].length;
+      return snapshot->data + sections[i].offset;
+    }
+  return nullptr;
+}
+
 /**
  * hb_face_set_get_table_tags_func:
  * @face: A face object
@@ -904,6 +1178,130 @@ hb_face_set_get_table_tags_func (hb_face_t *face,
   face->get_table_tags_destroy = destroy;
 }
 
+/**
+ * hb_face_set_sanitize_cache_funcs:
+ * @face: A face object
+ * @key: (array fixed-size=16): A secret key to hash tables with
+ * @lookup_func: (nullable): The function to ask whether a table is known to be clean
+ * @record_func: (nullable): The function to record a table that sanitized clean
+ * @user_data: A pointer to the user data, to be destroyed by @destroy when not needed anymore
+ * @destroy: (nullable): A callback to call when @user_data is not needed anymore
+ *
+ * Sets up a sanitize-result cache for the specified face object.
+ *
+ * Before a table of @face is sanitized, a 64-bit digest of its data,
+ * its tag, the glyph count of the face and the HarfBuzz version is
+ * computed with SipHash-2-4 under @key, and @lookup_func is asked
+ * whether that digest was seen before.  If it was, the table is used without being sanitized.
+ * Otherwise the table is sanitized as usual, and if it passes without
+ * needing any edits, @record_func is called with the digest so it can
+ * be stored, for example in a file shared by later runs.
+ *
+ * Hashing reads every byte of a table, while sanitizing often does
+ * not, so the cache only pays off for tables whose sanitizing is
+ * expensive; for many fonts, sanitizing is the cheaper of the two.
+ * Tables that are sanitized lazily, like `glyf`, are never looked up.
+ *
+ * @key keeps fonts from being crafted to match a recorded digest: it
+ * must be random and secret, for example generated when the store is
+ * created and kept with it, out of reach of whoever supplies fonts.
+ * Digests recorded under one key are never matched under another.
+ *
+ * @lookup_func and @record_func are called whenever a table of @face
+ * is loaded, which can happen from several threads at once; they must
+ * be thread-safe.
+ *
+ * <note>The store behind @lookup_func must be trusted: a table it
+ * vouches for is accessed without bounds checks beyond those done
+ * at use time, so a bogus answer can make HarfBuzz read out of
+ * bounds.</note>
+ *
+ * Since: REPLACEME
+ */
+void
+hb_face_set_sanitize_cache_funcs (hb_face_t                       *face,
+				  const uint8_t                   *key,
+				  hb_sanitize_cache_lookup_func_t  lookup_func,
+				  hb_sanitize_cache_record_func_t  record_func,
+				  void                            *user_data,
+				  hb_destroy_func_t                destroy)
+{
+  if (hb_object_is_immutable (face) || unlikely (!key))
+  {
+    if (destroy)
+      destroy (user_data);
+    return;
+  }
+
+  if (face->sanitize_cache_destroy)
+    face->sanitize_cache_destroy (face->sanitize_cache_user_data);
+
+  face->sanitize_cache_key[0] = face->sanitize_cache_key[1] = 0;
+  for (unsigned i = 0; i < 16; i++)
+    face->sanitize_cache_key[i / 8] |= (uint64_t) key[i] << (8 * (i % 8));
+  face->sanitize_cache_lookup_func = lookup_func;
+  face->sanitize_cache_record_func = record_func;
+  face->sanitize_cache_user_data = user_data;
+  face->sanitize_cache_destroy = destroy;
+}
+
+bool
+_hb_face_sanitize_cache_lookup (const hb_face_t *face,
+				hb_tag_t         tag,
+				const hb_blob_t *blob,
+				unsigned int     num_glyphs,
+				bool             lazy,
+				uint64_t        *digest /* OUT */)
+{
+  *digest = 0;
+
+  if (likely (!face->sanitize_cache_lookup_func && !face->sanitize_cache_record_func))
+    return false;
+
+  /* Not worth hashing; these are only checked as they are used. */
+  switch (tag)
+  {
+    case HB_TAG ('g','l','y','f'):
+    case HB_TAG ('l','o','c','a'):
+    case HB_TAG ('h','m','t','x'):
+    case HB_TAG ('v','m','t','x'):
+      return false;
+  }
+
+  if (!blob->length)
+    return false;
+
+  /* Anything the sanitizer result depends on is hashed along with the
+   * hash of the data. */
+  const uint64_t *key = face->sanitize_cache_key;
+  uint64_t params[3] = {
+    hb_siphash24 (blob->data, blob->length, key[0], key[1]),
+    ((uint64_t) tag << 32) | num_glyphs,
+    ((uint64_t) lazy << 63) |
+    ((uint64_t) HB_VERSION_MAJOR << 32) |
+    ((uint64_t) HB_VERSION_MINOR << 16) |
+    HB_VERSION_MICRO,
+  };
+  *digest = hb_siphash24 (params, sizeof (params), key[0], key[1]);
+  if (unlikely (!*digest))
+    *digest = 1;
+
+  return face->sanitize_cache_lookup_func &&
+	 face->sanitize_cache_lookup_func (face, tag, *digest, blob->length,
+					   face->sanitize_cache_user_data);
+}
+
+void
+_hb_face_sanitize_cache_record (const hb_face_t *face,
+				hb_tag_t         tag,
+				uint64_t         digest,
+				unsigned int     length)
+{
+  if (face->sanitize_cache_record_func)
+    face->sanitize_cache_record_func (face, tag, digest, length,
+				      face->sanitize_cache_user_data);
+}
+
 /**
  * hb_face_get_table_tags:
  * @face: A face object
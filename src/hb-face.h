@@ -162,6 +162,30 @@ hb_face_set_glyph_count (hb_face_t    *face,
 HB_EXTERN unsigned int
 hb_face_get_glyph_count (const hb_face_t *face);
 
+HB_EXTERN void
+hb_face_warmup (hb_face_t          *face,
+		const hb_tag_t     *table_tags,
+		unsigned int        table_count,
+		hb_executor_func_t  executor,
+		void               *executor_data);
+
+HB_EXTERN hb_blob_t *
+hb_face_serialize_accelerators (hb_face_t *face);
+
+HB_EXTERN hb_bool_t
+hb_face_attach_accelerators (hb_face_t *face,
+			     hb_blob_t *blob);
+
+HB_EXTERN unsigned int
+hb_face_get_memory_usage (const hb_face_t *face,
+			  unsigned int     start_offset,
+			  unsigned int    *entry_count, /* IN/OUT */
+			  hb_tag_t        *tags,        /* OUT */
+			  unsigned int    *sizes        /* OUT */);
+
+HB_EXTERN void
+hb_face_trim (hb_face_t *face);
+
 
 /**
  * hb_get_table_tags_func_t:
@@ -190,6 +214,54 @@ hb_face_set_get_table_tags_func (hb_face_t *face,
 				 void                    *user_data,
 				 hb_destroy_func_t        destroy);
 
+/**
+ * hb_sanitize_cache_lookup_func_t:
+ * @face: A face object
+ * @table_tag: The tag of the table being loaded
+ * @digest: A keyed hash of the table data and of the conditions it is sanitized under
+ * @length: The length of the table data, in bytes
+ * @user_data: User data pointer passed by the caller
+ *
+ * Callback function for hb_face_set_sanitize_cache_funcs(), asking
+ * whether a table with this @digest and @length was recorded before.
+ *
+ * Return value: `true` if the table is known to sanitize clean, `false` otherwise
+ *
+ * Since: REPLACEME
+ */
+typedef hb_bool_t (*hb_sanitize_cache_lookup_func_t) (const hb_face_t *face,
+						       hb_tag_t         table_tag,
+						       uint64_t         digest,
+						       unsigned int     length,
+						       void            *user_data);
+
+/**
+ * hb_sanitize_cache_record_func_t:
+ * @face: A face object
+ * @table_tag: The tag of the table that was loaded
+ * @digest: A keyed hash of the table data and of the conditions it was sanitized under
+ * @length: The length of the table data, in bytes
+ * @user_data: User data pointer passed by the caller
+ *
+ * Callback function for hb_face_set_sanitize_cache_funcs(), called when
+ * a table passed sanitizing without needing any edits.
+ *
+ * Since: REPLACEME
+ */
+typedef void (*hb_sanitize_cache_record_func_t) (const hb_face_t *face,
+						  hb_tag_t         table_tag,
+						  uint64_t         digest,
+						  unsigned int     length,
+						  void            *user_data);
+
+HB_EXTERN void
+hb_face_set_sanitize_cache_funcs (hb_face_t                       *face,
+				  const uint8_t                   *key,
+				  hb_sanitize_cache_lookup_func_t  lookup_func,
+				  hb_sanitize_cache_record_func_t  record_func,
+				  void                            *user_data,
+				  hb_destroy_func_t                destroy);
+
 HB_EXTERN unsigned int
 hb_face_get_table_tags (const hb_face_t *face,
 			unsigned int  start_offset,
@@ -60,17 +60,20 @@ struct hb_face_t
   void                      *get_table_tags_user_data;
   hb_destroy_func_t          get_table_tags_destroy;
 
+  uint64_t                        sanitize_cache_key[2];
+  hb_sanitize_cache_lookup_func_t sanitize_cache_lookup_func;
+  hb_sanitize_cache_record_func_t sanitize_cache_record_func;
+  void                           *sanitize_cache_user_data;
+  hb_destroy_func_t               sanitize_cache_destroy;
+
+  hb_blob_t *snapshot;			/* Attached accelerator snapshot. */
+
   hb_shaper_object_dataset_t<hb_face_t> data;/* Various shaper data. */
   hb_ot_face_t table;			/* All the face's tables. */
 
   /* Cache */
-  struct plan_node_t
-  {
-    hb_shape_plan_t *shape_plan;
-    plan_node_t *next;
-  };
 #ifndef HB_NO_SHAPER
-  hb_atomic_t<plan_node_t *> shape_plans;
+  hb_atomic_t<hb_shape_plan_cache_t *> shape_plans; /* Created on first use. */
 #endif
 
   hb_blob_t *reference_table (hb_tag_t tag) const
@@ -105,6 +108,10 @@ struct hb_face_t
     return ret;
   }
 
+  /* Returns the section of the attached snapshot built from table
+   * tag, or nullptr; see hb-face-snapshot.hh. */
+  HB_INTERNAL const void *get_snapshot_section (hb_tag_t tag, unsigned *length) const;
+
   private:
   HB_INTERNAL unsigned int load_upem () const;
   HB_INTERNAL unsigned int load_num_glyphs () const;
@@ -32,6 +32,7 @@
 #include "hb-draw.hh"
 #include "hb-paint.hh"
 #include "hb-machinery.hh"
+#include "hb-shape-cache.hh"
 
 #include "hb-ot.h"
 
@@ -1441,6 +1442,10 @@ hb_font_get_glyph_shape (hb_font_t *font,
  * The outline is returned by way of calls to the callbacks of the @dfuncs
  * objects, with @draw_data passed to them.
  *
+ * If an outline cache was enabled on @font using
+ * hb_font_set_outline_cache(), the outline may be replayed from the
+ * cache.
+ *
  * Return value: `true` if glyph was drawn, `false` otherwise
  *
  * XSince: REPLACEME
@@ -1450,6 +1455,10 @@ hb_font_draw_glyph_or_fail (hb_font_t *font,
 			    hb_codepoint_t glyph,
 			    hb_draw_funcs_t *dfuncs, void *draw_data)
 {
+#ifndef HB_NO_OUTLINE
+  if (font->outline_cache)
+    return font->outline_cache->draw (font, glyph, dfuncs, draw_data);
+#endif
   return font->draw_glyph_or_fail (glyph, dfuncs, draw_data);
 }
 
@@ -1537,6 +1546,295 @@ hb_font_draw_glyph (hb_font_t *font,
   (void) hb_font_draw_glyph_or_fail (font, glyph, dfuncs, draw_data);
 }
 
+/**
+ * hb_font_set_outline_cache:
+ * @font: #hb_font_t to work upon
+ * @max_memory: maximum number of bytes to spend on cached outlines
+ *
+ * Enables caching of glyph outlines on @font.  When enabled,
+ * hb_font_draw_glyph() and hb_font_draw_glyph_or_fail() remember the
+ * scaled outline of each glyph they draw, and when the same glyph is
+ * drawn again, replay the remembered outline to the draw functions
+ * instead of decoding the glyph, and applying variations to it, again.
+ *
+ * Outlines are cached per glyph and variation coordinates, such that
+ * switching between a few instances of a variable font keeps the
+ * cache warm.  Changing any other property of @font, or any property
+ * of its parents, discards all cached outlines.  Least-recently-used
+ * outlines are discarded when the cache would otherwise grow beyond
+ * @max_memory bytes.
+ *
+ * Passing zero for @max_memory disables the cache and releases its
+ * memory.  The cache is safe to use from multiple threads drawing
+ * with @font concurrently, but this function itself is not.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_set_outline_cache (hb_font_t    *font,
+			   unsigned int  max_memory)
+{
+#ifndef HB_NO_OUTLINE
+  if (hb_object_is_immutable (font))
+    return;
+
+  if (!max_memory)
+  {
+    hb_outline_cache_t::destroy (font->outline_cache);
+    font->outline_cache = nullptr;
+    return;
+  }
+
+  if (font->outline_cache)
+  {
+    font->outline_cache->set_max_memory (max_memory);
+    return;
+  }
+
+  font->outline_cache = hb_outline_cache_t::create (max_memory);
+#endif
+}
+
+/**
+ * hb_font_get_outline_cache_stats:
+ * @font: #hb_font_t to work upon
+ * @hits: (out) (optional): number of outlines replayed from the cache
+ * @misses: (out) (optional): number of outlines not found in the cache
+ * @evictions: (out) (optional): number of outlines discarded to stay within budget
+ * @memory: (out) (optional): number of bytes currently used by the cache
+ *
+ * Fetches statistics about the outline cache of @font, as enabled by
+ * hb_font_set_outline_cache().  All values are zero if the cache is
+ * not enabled.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_get_outline_cache_stats (hb_font_t    *font,
+				 unsigned int *hits,
+				 unsigned int *misses,
+				 unsigned int *evictions,
+				 unsigned int *memory)
+{
+#ifndef HB_NO_OUTLINE
+  if (font->outline_cache)
+  {
+    font->outline_cache->get_stats (hits, misses, evictions, memory);
+    return;
+  }
+#endif
+
+  if (hits) *hits = 0;
+  if (misses) *misses = 0;
+  if (evictions) *evictions = 0;
+  if (memory) *memory = 0;
+}
+
+
+/*
+ * hb_frozen_instance_t
+ */
+
+template <typename K, typename V>
+static unsigned
+_hb_hashmap_memory (const hb_hashmap_t<K, V> &map)
+{
+  return map.size () * sizeof (typename hb_hashmap_t<K, V>::item_t);
+}
+
+static bool
+_hb_frozen_instance_fill_carets (hb_font_t *font,
+				 hb_direction_t direction,
+				 unsigned int glyph_count,
+				 hb_hashmap_t<hb_codepoint_t, hb_vector_t<hb_position_t>> &carets)
+{
+#if !defined(HB_NO_OT_LAYOUT) && !defined(HB_NO_LAYOUT_UNUSED)
+  for (hb_codepoint_t glyph = 0; glyph < glyph_count; glyph++)
+  {
+    unsigned int count = 0;
+    unsigned int total = hb_ot_layout_get_ligature_carets (font, direction, glyph, 0, &count, nullptr);
+    if (!total) continue;
+
+    hb_vector_t<hb_position_t> positions;
+    if (unlikely (!positions.resize_exact (total, false)))
+      return false;
+    count = total;
+    hb_ot_layout_get_ligature_carets (font, direction, glyph, 0, &count, positions.arrayZ);
+    if (unlikely (!carets.set (glyph, std::move (positions))))
+      return false;
+  }
+#endif
+  return true;
+}
+
+hb_frozen_instance_t *
+hb_frozen_instance_t::create (hb_font_t *font)
+{
+  hb_frozen_instance_t *frozen = (hb_frozen_instance_t *) hb_calloc (1, sizeof (hb_frozen_instance_t));
+  if (unlikely (!frozen)) return nullptr;
+  new (frozen) hb_frozen_instance_t ();
+
+  /* Everything is queried with frozen lookups off, since font has no
+   * frozen instance while this runs. */
+
+  unsigned int glyph_count = font->face->get_num_glyphs ();
+
+  hb_vector_t<hb_codepoint_t> glyphs;
+  if (unlikely (!glyphs.resize_exact (glyph_count, false) ||
+		!frozen->h_advances.resize_exact (glyph_count, false) ||
+		!frozen->v_advances.resize_exact (glyph_count, false) ||
+		!frozen->v_origins.resize_exact (glyph_count, false) ||
+		!frozen->glyph_extents.resize_exact (glyph_count, false) ||
+		!frozen->glyph_extents_ret.resize_exact (glyph_count, false)))
+    goto fail;
+
+  for (hb_codepoint_t glyph = 0; glyph < glyph_count; glyph++)
+    glyphs.arrayZ[glyph] = glyph;
+
+  frozen->h_extents_ret = font->get_font_h_extents (&frozen->h_extents, false);
+  frozen->v_extents_ret = font->get_font_v_extents (&frozen->v_extents, false);
+
+  font->get_glyph_h_advances (glyph_count,
+			      glyphs.arrayZ, sizeof (glyphs.arrayZ[0]),
+			      frozen->h_advances.arrayZ, sizeof (frozen->h_advances.arrayZ[0]),
+			      false);
+  font->get_glyph_v_advances (glyph_count,
+			      glyphs.arrayZ, sizeof (glyphs.arrayZ[0]),
+			      frozen->v_advances.arrayZ, sizeof (frozen->v_advances.arrayZ[0]),
+			      false);
+
+  for (hb_codepoint_t glyph = 0; glyph < glyph_count; glyph++)
+  {
+    origin_t &origin = frozen->v_origins.arrayZ[glyph];
+    origin.ret = font->get_glyph_v_origin (glyph, &origin.x, &origin.y);
+
+    frozen->glyph_extents_ret.arrayZ[glyph] = font->get_glyph_extents (glyph,
+								       &frozen->glyph_extents.arrayZ[glyph],
+								       false);
+  }
+
+#ifndef HB_NO_METRICS
+  {
+    static const hb_ot_metrics_tag_t metrics_tags[] =
+    {
+      HB_OT_METRICS_TAG_HORIZONTAL_ASCENDER,
+      HB_OT_METRICS_TAG_HORIZONTAL_DESCENDER,
+      HB_OT_METRICS_TAG_HORIZONTAL_LINE_GAP,
+      HB_OT_METRICS_TAG_HORIZONTAL_CLIPPING_ASCENT,
+      HB_OT_METRICS_TAG_HORIZONTAL_CLIPPING_DESCENT,
+      HB_OT_METRICS_TAG_VERTICAL_ASCENDER,
+      HB_OT_METRICS_TAG_VERTICAL_DESCENDER,
+      HB_OT_METRICS_TAG_VERTICAL_LINE_GAP,
+      HB_OT_METRICS_TAG_HORIZONTAL_CARET_RISE,
+      HB_OT_METRICS_TAG_HORIZONTAL_CARET_RUN,
+      HB_OT_METRICS_TAG_HORIZONTAL_CARET_OFFSET,
+      HB_OT_METRICS_TAG_VERTICAL_CARET_RISE,
+      HB_OT_METRICS_TAG_VERTICAL_CARET_RUN,
+      HB_OT_METRICS_TAG_VERTICAL_CARET_OFFSET,
+      HB_OT_METRICS_TAG_X_HEIGHT,
+      HB_OT_METRICS_TAG_CAP_HEIGHT,
+      HB_OT_METRICS_TAG_SUBSCRIPT_EM_X_SIZE,
+      HB_OT_METRICS_TAG_SUBSCRIPT_EM_Y_SIZE,
+      HB_OT_METRICS_TAG_SUBSCRIPT_EM_X_OFFSET,
+      HB_OT_METRICS_TAG_SUBSCRIPT_EM_Y_OFFSET,
+      HB_OT_METRICS_TAG_SUPERSCRIPT_EM_X_SIZE,
+      HB_OT_METRICS_TAG_SUPERSCRIPT_EM_Y_SIZE,
+      HB_OT_METRICS_TAG_SUPERSCRIPT_EM_X_OFFSET,
+      HB_OT_METRICS_TAG_SUPERSCRIPT_EM_Y_OFFSET,
+      HB_OT_METRICS_TAG_STRIKEOUT_SIZE,
+      HB_OT_METRICS_TAG_STRIKEOUT_OFFSET,
+      HB_OT_METRICS_TAG_UNDERLINE_SIZE,
+      HB_OT_METRICS_TAG_UNDERLINE_OFFSET,
+    };
+    for (hb_ot_metrics_tag_t tag : metrics_tags)
+    {
+      hb_position_t position;
+      if (hb_ot_metrics_get_position (font, tag, &position) &&
+	  unlikely (!frozen->metrics.set (tag, position)))
+	goto fail;
+    }
+  }
+#endif
+
+  if (unlikely (!_hb_frozen_instance_fill_carets (font, HB_DIRECTION_LTR, glyph_count, frozen->h_carets) ||
+		!_hb_frozen_instance_fill_carets (font, HB_DIRECTION_TTB, glyph_count, frozen->v_carets)))
+    goto fail;
+
+  frozen->parent_serial = 0;
+  for (hb_font_t *parent = font->parent; parent; parent = parent->parent)
+    frozen->parent_serial += parent->serial.get_acquire ();
+
+  frozen->memory = sizeof (*frozen) +
+		   frozen->h_advances.get_size () +
+		   frozen->v_advances.get_size () +
+		   frozen->v_origins.get_size () +
+		   frozen->glyph_extents.get_size () +
+		   frozen->glyph_extents_ret.get_size () +
+		   _hb_hashmap_memory (frozen->metrics) +
+		   _hb_hashmap_memory (frozen->h_carets) +
+		   _hb_hashmap_memory (frozen->v_carets);
+  for (const auto &_ : frozen->h_carets.values_ref ())
+    frozen->memory += _.get_size ();
+  for (const auto &_ : frozen->v_carets.values_ref ())
+    frozen->memory += _.get_size ();
+
+  return frozen;
+
+fail:
+  destroy (frozen);
+  return nullptr;
+}
+
+/**
+ * hb_font_freeze_instance:
+ * @font: #hb_font_t to work upon
+ * @memory: (out) (optional): number of bytes used by the frozen data
+ *
+ * Materializes, for the current variation coordinates, scale, and
+ * other settings of @font, everything variations would otherwise be
+ * applied to on every call: the advances, vertical origins and extents
+ * of all glyphs, the font extents, the metrics returned by
+ * hb_ot_metrics_get_position(), and the ligature carets returned by
+ * hb_ot_layout_get_ligature_carets().  The deltas of the GDEF item
+ * variation store, used for GPOS device tables, are baked for the
+ * instance as well.  After this, shaping and querying @font runs about
+ * as fast as it would with a static font.
+ *
+ * This walks every glyph of the font, so it is only worth it for fonts
+ * that are used for long enough.  Setting any property of @font, or of
+ * its parents, discards the frozen data; call this function again to
+ * rebuild it.  Calling it on a font that is not variable is allowed,
+ * but only saves the cost of looking glyph data up in the font tables.
+ *
+ * Return value: `true` if the instance was frozen, `false` on
+ * allocation failure or if @font is immutable.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_font_freeze_instance (hb_font_t    *font,
+			 unsigned int *memory)
+{
+  if (memory) *memory = 0;
+
+  if (hb_object_is_immutable (font))
+    return false;
+
+  hb_frozen_instance_t::destroy (font->frozen_instance);
+  font->frozen_instance = nullptr;
+
+  hb_frozen_instance_t *frozen = hb_frozen_instance_t::create (font);
+  if (unlikely (!frozen))
+    return false;
+
+  font->frozen_instance = frozen;
+  /* Rebuild the shaper data, to bake the variation deltas in. */
+  font->data.fini ();
+
+  if (memory) *memory = frozen->memory;
+  return true;
+}
+
 /**
  * hb_font_paint_glyph:
  * @font: #hb_font_t to work upon
@@ -2097,6 +2395,10 @@ hb_font_destroy (hb_font_t *font)
   hb_face_destroy (font->face);
   hb_font_funcs_destroy (font->klass);
 
+  hb_shape_cache_t::destroy (font->shape_cache);
+  hb_outline_cache_t::destroy (font->outline_cache);
+  hb_frozen_instance_t::destroy (font->frozen_instance);
+
   hb_free (font->coords);
   hb_free (font->design_coords);
 
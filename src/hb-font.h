@@ -988,6 +988,21 @@ hb_font_draw_glyph (hb_font_t *font,
 		    hb_codepoint_t glyph,
 		    hb_draw_funcs_t *dfuncs, void *draw_data);
 
+HB_EXTERN void
+hb_font_set_outline_cache (hb_font_t    *font,
+			   unsigned int  max_memory);
+
+HB_EXTERN void
+hb_font_get_outline_cache_stats (hb_font_t    *font,
+				 unsigned int *hits,
+				 unsigned int *misses,
+				 unsigned int *evictions,
+				 unsigned int *memory);
+
+HB_EXTERN hb_bool_t
+hb_font_freeze_instance (hb_font_t    *font,
+			 unsigned int *memory);
+
 /* Paints color glyph; if failed, draws outline glyph. */
 HB_EXTERN void
 hb_font_paint_glyph (hb_font_t *font,
@@ -37,6 +37,7 @@
 #include "hb-paint-extents.hh"
 #include "hb-shaper.hh"
 #include "hb-outline.hh"
+#include "hb-frozen-instance.hh"
 
 
 /*
@@ -106,6 +107,9 @@ DECLARE_NULL_INSTANCE (hb_font_funcs_t);
 #include "hb-shaper-list.hh"
 #undef HB_SHAPER_IMPLEMENT
 
+struct hb_shape_cache_t;
+struct hb_outline_cache_t;
+
 struct hb_font_t
 {
   hb_object_header_t header;
@@ -149,6 +153,10 @@ struct hb_font_t
 
   hb_shaper_object_dataset_t<hb_font_t> data; /* Various shaper data. */
 
+  hb_shape_cache_t *shape_cache; /* Shaping results; see hb_font_set_shape_cache(). */
+  hb_outline_cache_t *outline_cache; /* Glyph outlines; see hb_font_set_outline_cache(). */
+  hb_frozen_instance_t *frozen_instance; /* Baked glyph data; see hb_font_freeze_instance(). */
+
 
   /* Convert from font-space to user-space */
   int64_t dir_mult (hb_direction_t direction)
@@ -270,9 +278,16 @@ struct hb_font_t
 				bool synthetic = true)
   {
     hb_memset (extents, 0, sizeof (*extents));
-    bool ret = klass->get.f.font_h_extents (this, user_data,
-					    extents,
-					    !klass->user_data ? nullptr : klass->user_data->font_h_extents);
+    bool ret;
+    if (const hb_frozen_instance_t *frozen = get_frozen_instance ())
+    {
+      *extents = frozen->h_extents;
+      ret = frozen->h_extents_ret;
+    }
+    else
+      ret = klass->get.f.font_h_extents (this, user_data,
+					 extents,
+					 !klass->user_data ? nullptr : klass->user_data->font_h_extents);
 
     if (synthetic && ret)
     {
@@ -287,9 +302,16 @@ struct hb_font_t
 				bool synthetic = true)
   {
     hb_memset (extents, 0, sizeof (*extents));
-    bool ret = klass->get.f.font_v_extents (this, user_data,
-					    extents,
-					    !klass->user_data ? nullptr : klass->user_data->font_v_extents);
+    bool ret;
+    if (const hb_frozen_instance_t *frozen = get_frozen_instance ())
+    {
+      *extents = frozen->v_extents;
+      ret = frozen->v_extents_ret;
+    }
+    else
+      ret = klass->get.f.font_v_extents (this, user_data,
+					 extents,
+					 !klass->user_data ? nullptr : klass->user_data->font_v_extents);
 
     if (synthetic && ret)
     {
@@ -348,9 +370,12 @@ struct hb_font_t
   hb_position_t get_glyph_h_advance (hb_codepoint_t glyph,
 				     bool synthetic = true)
   {
-    hb_position_t advance = klass->get.f.glyph_h_advance (this, user_data,
-							  glyph,
-							  !klass->user_data ? nullptr : klass->user_data->glyph_h_advance);
+    hb_position_t advance;
+    const hb_frozen_instance_t *frozen = get_frozen_instance ();
+    if (!frozen || !frozen->get_glyph_h_advance (glyph, &advance))
+      advance = klass->get.f.glyph_h_advance (this, user_data,
+					       glyph,
+					       !klass->user_data ? nullptr : klass->user_data->glyph_h_advance);
 
     if (synthetic && x_strength && !embolden_in_place)
     {
@@ -365,9 +390,12 @@ struct hb_font_t
   hb_position_t get_glyph_v_advance (hb_codepoint_t glyph,
 				     bool synthetic = true)
   {
-    hb_position_t advance = klass->get.f.glyph_v_advance (this, user_data,
-							  glyph,
-							  !klass->user_data ? nullptr : klass->user_data->glyph_v_advance);
+    hb_position_t advance;
+    const hb_frozen_instance_t *frozen = get_frozen_instance ();
+    if (!frozen || !frozen->get_glyph_v_advance (glyph, &advance))
+      advance = klass->get.f.glyph_v_advance (this, user_data,
+					       glyph,
+					       !klass->user_data ? nullptr : klass->user_data->glyph_v_advance);
 
     if (synthetic && y_strength && !embolden_in_place)
     {
@@ -386,11 +414,16 @@ struct hb_font_t
 			     unsigned int advance_stride,
 			     bool synthetic = true)
   {
-    klass->get.f.glyph_h_advances (this, user_data,
-				   count,
-				   first_glyph, glyph_stride,
-				   first_advance, advance_stride,
-				   !klass->user_data ? nullptr : klass->user_data->glyph_h_advances);
+    const hb_frozen_instance_t *frozen = get_frozen_instance ();
+    if (!frozen || !frozen->get_glyph_advances (false,
+						count,
+						first_glyph, glyph_stride,
+						first_advance, advance_stride))
+      klass->get.f.glyph_h_advances (this, user_data,
+				     count,
+				     first_glyph, glyph_stride,
+				     first_advance, advance_stride,
+				     !klass->user_data ? nullptr : klass->user_data->glyph_h_advances);
 
     if (synthetic && x_strength && !embolden_in_place)
     {
@@ -411,11 +444,16 @@ struct hb_font_t
 			     unsigned int advance_stride,
 			     bool synthetic = true)
   {
-    klass->get.f.glyph_v_advances (this, user_data,
-				   count,
-				   first_glyph, glyph_stride,
-				   first_advance, advance_stride,
-				   !klass->user_data ? nullptr : klass->user_data->glyph_v_advances);
+    const hb_frozen_instance_t *frozen = get_frozen_instance ();
+    if (!frozen || !frozen->get_glyph_advances (true,
+						count,
+						first_glyph, glyph_stride,
+						first_advance, advance_stride))
+      klass->get.f.glyph_v_advances (this, user_data,
+				     count,
+				     first_glyph, glyph_stride,
+				     first_advance, advance_stride,
+				     !klass->user_data ? nullptr : klass->user_data->glyph_v_advances);
 
     if (synthetic && y_strength && !embolden_in_place)
     {
@@ -442,6 +480,10 @@ struct hb_font_t
 				hb_position_t *x, hb_position_t *y)
   {
     *x = *y = 0;
+    hb_bool_t ret;
+    const hb_frozen_instance_t *frozen = get_frozen_instance ();
+    if (frozen && frozen->get_glyph_v_origin (glyph, x, y, &ret))
+      return ret;
     return klass->get.f.glyph_v_origin (this, user_data,
 					glyph, x, y,
 					!klass->user_data ? nullptr : klass->user_data->glyph_v_origin);
@@ -471,6 +513,19 @@ struct hb_font_t
 #endif
   }
 
+  hb_bool_t get_glyph_extents_raw (hb_codepoint_t glyph,
+				   hb_glyph_extents_t *extents)
+  {
+    hb_bool_t ret;
+    const hb_frozen_instance_t *frozen = get_frozen_instance ();
+    if (frozen && frozen->get_glyph_extents (glyph, extents, &ret))
+      return ret;
+    return klass->get.f.glyph_extents (this, user_data,
+				       glyph,
+				       extents,
+				       !klass->user_data ? nullptr : klass->user_data->glyph_extents);
+  }
+
   hb_bool_t get_glyph_extents (hb_codepoint_t glyph,
 			       hb_glyph_extents_t *extents,
 			       bool synthetic = true)
@@ -480,17 +535,9 @@ struct hb_font_t
     /* This is rather messy, but necessary. */
 
     if (!synthetic)
-    {
-      return klass->get.f.glyph_extents (this, user_data,
-					 glyph,
-					 extents,
-					 !klass->user_data ? nullptr : klass->user_data->glyph_extents);
-    }
+      return get_glyph_extents_raw (glyph, extents);
     if (!is_synthetic () &&
-	klass->get.f.glyph_extents (this, user_data,
-				    glyph,
-				    extents,
-				    !klass->user_data ? nullptr : klass->user_data->glyph_extents))
+	get_glyph_extents_raw (glyph, extents))
       return true;
 
     /* Try getting extents from paint(), then draw(), *then* get_extents()
@@ -513,10 +560,7 @@ struct hb_font_t
       return true;
     }
 
-    bool ret = klass->get.f.glyph_extents (this, user_data,
-					   glyph,
-					   extents,
-					   !klass->user_data ? nullptr : klass->user_data->glyph_extents);
+    bool ret = get_glyph_extents_raw (glyph, extents);
     if (ret)
       synthetic_glyph_extents (extents);
 
@@ -890,6 +934,17 @@ struct hb_font_t
     return false;
   }
 
+  /* Returns the frozen instance, unless a parent font changed since it
+   * was built. */
+  const hb_frozen_instance_t *get_frozen_instance () const
+  {
+    if (likely (!frozen_instance)) return nullptr;
+    unsigned parent_serial = 0;
+    for (const hb_font_t *p = parent; p; p = p->parent)
+      parent_serial += p->serial.get_acquire ();
+    return parent_serial == frozen_instance->parent_serial ? frozen_instance : nullptr;
+  }
+
   bool is_synthetic () const
   {
     return x_embolden || y_embolden || slant;
@@ -913,6 +968,9 @@ struct hb_font_t
 
     data.fini ();
 
+    hb_frozen_instance_t::destroy (frozen_instance);
+    frozen_instance = nullptr;
+
     serial++;
   }
 
@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Google Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_FROZEN_INSTANCE_HH
+#define HB_FROZEN_INSTANCE_HH
+
+#include "hb.hh"
+
+#include "hb-map.hh"
+#include "hb-vector.hh"
+
+
+/* Font data materialized for one state of a font; see
+ * hb_font_freeze_instance().
+ *
+ * Holds what the font functions returned, before any synthetic
+ * adjustments, for every glyph, plus the MVAR-derived metrics and the
+ * GDEF ligature carets.  Setting any property of the font discards it;
+ * changes to parent fonts are detected using their serial numbers.
+ *
+ * Immutable once built, so lookups need no locking. */
+
+struct hb_frozen_instance_t
+{
+  HB_INTERNAL static hb_frozen_instance_t *create (hb_font_t *font);
+  static void destroy (hb_frozen_instance_t *frozen)
+  {
+    if (!frozen) return;
+    frozen->~hb_frozen_instance_t ();
+    hb_free (frozen);
+  }
+
+  bool get_glyph_h_advance (hb_codepoint_t glyph, hb_position_t *advance) const
+  {
+    if (unlikely (glyph >= h_advances.length)) return false;
+    *advance = h_advances.arrayZ[glyph];
+    return true;
+  }
+  bool get_glyph_v_advance (hb_codepoint_t glyph, hb_position_t *advance) const
+  {
+    if (unlikely (glyph >= v_advances.length)) return false;
+    *advance = v_advances.arrayZ[glyph];
+    return true;
+  }
+
+  /* Returns false, having possibly written some advances, if any glyph
+   * is out of range. */
+  bool get_glyph_advances (bool vertical,
+			   unsigned int count,
+			   const hb_codepoint_t *first_glyph,
+			   unsigned int glyph_stride,
+			   hb_position_t *first_advance,
+			   unsigned int advance_stride) const
+  {
+    const hb_vector_t<hb_position_t> &advances = vertical ? v_advances : h_advances;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (unlikely (*first_glyph >= advances.length)) return false;
+      *first_advance = advances.arrayZ[*first_glyph];
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+    }
+    return true;
+  }
+
+  bool get_glyph_v_origin (hb_codepoint_t glyph,
+			   hb_position_t *x, hb_position_t *y,
+			   hb_bool_t *ret) const
+  {
+    if (unlikely (glyph >= v_origins.length)) return false;
+    const origin_t &origin = v_origins.arrayZ[glyph];
+    *x = origin.x;
+    *y = origin.y;
+    *ret = origin.ret;
+    return true;
+  }
+
+  bool get_glyph_extents (hb_codepoint_t glyph,
+			  hb_glyph_extents_t *extents,
+			  hb_bool_t *ret) const
+  {
+    if (unlikely (glyph >= glyph_extents.length)) return false;
+    *extents = glyph_extents.arrayZ[glyph];
+    *ret = glyph_extents_ret.arrayZ[glyph];
+    return true;
+  }
+
+  bool get_metric (hb_tag_t tag, hb_position_t *position) const
+  {
+    hb_position_t *v;
+    if (!metrics.has (tag, &v)) return false;
+    if (position) *position = *v;
+    return true;
+  }
+
+  /* Returns the carets of glyph, if it is a ligature with carets. */
+  const hb_vector_t<hb_position_t> *get_ligature_carets (bool vertical,
+							 hb_codepoint_t glyph) const
+  {
+    hb_vector_t<hb_position_t> *v;
+    return (vertical ? v_carets : h_carets).has (glyph, &v) ? v : nullptr;
+  }
+
+  struct origin_t
+  {
+    hb_position_t x;
+    hb_position_t y;
+    bool ret;
+  };
+
+  unsigned parent_serial;
+  unsigned memory;
+
+  hb_bool_t h_extents_ret;
+  hb_bool_t v_extents_ret;
+  hb_font_extents_t h_extents;
+  hb_font_extents_t v_extents;
+
+  hb_vector_t<hb_position_t> h_advances;
+  hb_vector_t<hb_position_t> v_advances;
+  hb_vector_t<origin_t> v_origins;
+  hb_vector_t<hb_glyph_extents_t> glyph_extents;
+  hb_vector_t<bool> glyph_extents_ret;
+
+  hb_hashmap_t<hb_tag_t, hb_position_t> metrics;
+  hb_hashmap_t<hb_codepoint_t, hb_vector_t<hb_position_t>> h_carets;
+  hb_hashmap_t<hb_codepoint_t, hb_vector_t<hb_position_t>> v_carets;
+};
+
+
+#endif /* HB_FROZEN_INSTANCE_HH */
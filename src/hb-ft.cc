@@ -86,19 +86,29 @@
  */
 
 
-using hb_ft_advance_cache_t = hb_cache_t<16, 24, 8, false>;
+using hb_ft_advance_cache_t = hb_sized_cache_t<16, 24>;
+
+/* The advance cache is sized from the glyph count by
+ * hb_glyph_cache_bits(), up to this many bits. */
+#ifndef HB_FT_ADVANCE_CACHE_MAX_BITS
+#define HB_FT_ADVANCE_CACHE_MAX_BITS 11
+#endif
+
+struct hb_ft_face_pool_t;
 
 struct hb_ft_font_t
 {
   int load_flags;
   bool symbol; /* Whether selected cmap is symbol cmap. */
   bool unref; /* Whether to destroy ft_face when done. */
-  bool transform; /* Whether to apply FT_Face's transform. */
+  hb_atomic_t<bool> transform; /* Whether to apply FT_Face's transform. */
 
   mutable hb_mutex_t lock; /* Protects members below. */
   FT_Face ft_face;
   mutable hb_atomic_t<unsigned> cached_serial;
-  mutable hb_ft_advance_cache_t advance_cache;
+  mutable hb_ft_advance_cache_t *advance_cache; /* May be nullptr. */
+
+  hb_ft_face_pool_t *face_pool; /* May be nullptr; see hb_ft_font_set_face_pool_size(). */
 };
 
 static hb_ft_font_t *
@@ -115,7 +125,9 @@ _hb_ft_font_create (FT_Face ft_face, bool symbol, bool unref)
   ft_font->load_flags = FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING;
 
   ft_font->cached_serial = UINT_MAX;
-  new (&ft_font->advance_cache) hb_ft_advance_cache_t;
+  unsigned num_glyphs = ft_face->num_glyphs > 0 ? (unsigned) ft_face->num_glyphs : 0;
+  unsigned cache_bits = hb_glyph_cache_bits (num_glyphs, HB_FT_ADVANCE_CACHE_MAX_BITS);
+  ft_font->advance_cache = hb_ft_advance_cache_t::create (cache_bits);
 
   return ft_font;
 }
@@ -126,6 +138,8 @@ _hb_ft_face_destroy (void *data)
   FT_Done_Face ((FT_Face) data);
 }
 
+static void _hb_ft_face_pool_destroy (hb_ft_face_pool_t *pool);
+
 static void
 _hb_ft_font_destroy (void *data)
 {
@@ -134,17 +148,20 @@ _hb_ft_font_destroy (void *data)
   if (ft_font->unref)
     _hb_ft_face_destroy (ft_font->ft_face);
 
+  hb_ft_advance_cache_t::destroy (ft_font->advance_cache);
+  _hb_ft_face_pool_destroy (ft_font->face_pool);
+
   ft_font->lock.fini ();
 
   hb_free (ft_font);
 }
 
 
-/* hb_font changed, update FT_Face. */
-static void _hb_ft_hb_font_changed (hb_font_t *font, FT_Face ft_face)
+/* hb_font changed, update FT_Face.  Returns whether a transform was set
+ * on ft_face. */
+static bool _hb_ft_hb_font_changed (hb_font_t *font, FT_Face ft_face)
 {
-  hb_ft_font_t *ft_font = (hb_ft_font_t *) font->user_data;
-
+  bool transform = false;
   float x_mult = 1.f, y_mult = 1.f;
 
   if (font->x_scale < 0) x_mult = -x_mult;
@@ -182,7 +199,7 @@ static void _hb_ft_hb_font_changed (hb_font_t *font, FT_Face ft_face)
     FT_Matrix matrix = { (int) roundf (x_mult * (1<<16)), 0,
 			  0, (int) roundf (y_mult * (1<<16))};
     FT_Set_Transform (ft_face, &matrix, nullptr);
-    ft_font->transform = true;
+    transform = true;
   }
 
 #if defined(HAVE_FT_GET_VAR_BLEND_COORDINATES) && !defined(HB_NO_VAR)
@@ -200,6 +217,8 @@ static void _hb_ft_hb_font_changed (hb_font_t *font, FT_Face ft_face)
     }
   }
 #endif
+
+  return transform;
 }
 
 /* Check if hb_font changed, update FT_Face. */
@@ -210,8 +229,10 @@ _hb_ft_hb_font_check_changed (hb_font_t *font,
   if (font->serial != ft_font->cached_serial)
   {
     hb_lock_t lock (ft_font->lock);
-    _hb_ft_hb_font_changed (font, ft_font->ft_face);
-    ft_font->advance_cache.clear ();
+    if (_hb_ft_hb_font_changed (font, ft_font->ft_face))
+      ((hb_ft_font_t *) font->user_data)->transform = true;
+    if (ft_font->advance_cache)
+      ft_font->advance_cache->clear ();
     ft_font->cached_serial.set_release (font->serial.get_acquire ());
     return true;
   }
@@ -219,6 +240,202 @@ _hb_ft_hb_font_check_changed (hb_font_t *font,
 }
 
 
+static FT_Library _hb_ft_new_library ();
+
+/* Extra FT_Faces over the same font data as the main FT_Face of an
+ * hb_ft_font_t, such that font functions called from several threads
+ * at once each get a face of their own instead of waiting on the main
+ * face's lock.  Faces are opened on demand, up to max_faces, and are
+ * set up like the main face when handed out. */
+struct hb_ft_face_pool_t
+{
+  struct item_t
+  {
+    FT_Face ft_face;
+    unsigned serial; /* hb_font_t serial ft_face is set up for. */
+    unsigned generation; /* Main face generation ft_face is set up for. */
+  };
+
+  static hb_ft_face_pool_t *create (hb_font_t *font,
+				    const hb_ft_font_t *ft_font,
+				    unsigned max_faces)
+  {
+    hb_ft_face_pool_t *pool = (hb_ft_face_pool_t *) hb_calloc (1, sizeof (hb_ft_face_pool_t));
+    if (unlikely (!pool)) return nullptr;
+    new (pool) hb_ft_face_pool_t ();
+
+    pool->lock.init ();
+    pool->max_faces = max_faces;
+    pool->face_index = ft_font->ft_face->face_index;
+    pool->charmap_index = ft_font->ft_face->charmap ? FT_Get_Charmap_Index (ft_font->ft_face->charmap) : -1;
+    pool->blob = hb_face_reference_blob (font->face);
+    pool->ft_library = _hb_ft_new_library ();
+
+    /* Items are handed out by pointer, so the array must never move. */
+    if (unlikely (!hb_blob_get_length (pool->blob) ||
+		  !pool->ft_library ||
+		  !pool->items.alloc_exact (max_faces) ||
+		  !pool->free_items.alloc_exact (max_faces)))
+    {
+      destroy (pool);
+      return nullptr;
+    }
+
+    return pool;
+  }
+
+  static void destroy (hb_ft_face_pool_t *pool)
+  {
+    if (!pool) return;
+    for (const item_t &item : pool->items)
+      FT_Done_Face (item.ft_face);
+    if (pool->ft_library)
+      FT_Done_Library (pool->ft_library);
+    hb_blob_destroy (pool->blob);
+    pool->lock.fini ();
+    pool->~hb_ft_face_pool_t ();
+    hb_free (pool);
+  }
+
+  /* Returns nullptr if all faces are in use. */
+  item_t *acquire (hb_font_t *font, const hb_ft_font_t *ft_font)
+  {
+    item_t *item = nullptr;
+    {
+      hb_lock_t l (lock);
+      if (free_items)
+	item = free_items.pop ();
+      else if (items.length < max_faces)
+	item = open_face ();
+    }
+    if (!item) return nullptr;
+
+    unsigned serial = font->serial.get_acquire ();
+    unsigned generation = this->generation.get_acquire ();
+    if (item->serial != serial || item->generation != generation)
+    {
+      set_up_face (font, ft_font, item->ft_face);
+      item->serial = serial;
+      item->generation = generation;
+    }
+    return item;
+  }
+
+  void release (item_t *item)
+  {
+    hb_lock_t l (lock);
+    free_items.push (item);
+  }
+
+  /* Bumped by hb_ft_font_changed(), for changes made to the main face
+   * directly. */
+  hb_atomic_t<unsigned> generation;
+
+  private:
+
+  /* Sets ft_face up like the main face: the variations come from font,
+   * and the size and transform are copied from the main face, which may
+   * carry ones its owner set on it directly.  The main face itself is
+   * left alone. */
+  static void set_up_face (hb_font_t *font, const hb_ft_font_t *ft_font, FT_Face ft_face)
+  {
+    _hb_ft_hb_font_check_changed (font, ft_font);
+    _hb_ft_hb_font_changed (font, ft_face);
+
+    hb_lock_t lock (ft_font->lock);
+    FT_Face main_face = ft_font->ft_face;
+    if (FT_IS_SCALABLE (main_face) && main_face->size)
+    {
+      FT_Size_RequestRec request = {FT_SIZE_REQUEST_TYPE_SCALES,
+				    main_face->size->metrics.x_scale,
+				    main_face->size->metrics.y_scale,
+				    0, 0};
+      FT_Request_Size (ft_face, &request);
+    }
+#ifdef HAVE_FT_GET_TRANSFORM
+    FT_Matrix matrix;
+    FT_Vector delta;
+    FT_Get_Transform (main_face, &matrix, &delta);
+    FT_Set_Transform (ft_face, &matrix, &delta);
+#endif
+  }
+
+  /* Called with lock held, which also serializes use of ft_library. */
+  item_t *open_face ()
+  {
+    unsigned int blob_length;
+    const char *blob_data = hb_blob_get_data (blob, &blob_length);
+
+    FT_Face ft_face = nullptr;
+    if (unlikely (FT_New_Memory_Face (ft_library,
+				      (const FT_Byte *) blob_data,
+				      blob_length,
+				      face_index,
+				      &ft_face)))
+      return nullptr;
+
+    if (charmap_index >= 0 && charmap_index < ft_face->num_charmaps)
+      FT_Set_Charmap (ft_face, ft_face->charmaps[charmap_index]);
+
+    item_t *item = items.push ();
+    item->ft_face = ft_face;
+    item->serial = UINT_MAX;
+    item->generation = 0;
+    return item;
+  }
+
+  hb_mutex_t lock; /* Protects members below. */
+  unsigned max_faces;
+  FT_Long face_index;
+  int charmap_index;
+  hb_blob_t *blob;
+  FT_Library ft_library;
+  hb_vector_t<item_t> items;
+  hb_vector_t<item_t *> free_items;
+};
+
+static void
+_hb_ft_face_pool_destroy (hb_ft_face_pool_t *pool)
+{
+  hb_ft_face_pool_t::destroy (pool);
+}
+
+/* Gives exclusive use of an FT_Face of ft_font, set up for font, for as
+ * long as it lives: one from the pool if there is one to spare, or else
+ * the main face, under its lock. */
+struct hb_ft_locked_face_t
+{
+  hb_ft_locked_face_t (hb_font_t *font, const hb_ft_font_t *ft_font) :
+    ft_font (ft_font)
+  {
+    if (ft_font->face_pool &&
+	(item = ft_font->face_pool->acquire (font, ft_font)))
+    {
+      ft_face = item->ft_face;
+      return;
+    }
+    ft_font->lock.lock ();
+    ft_face = ft_font->ft_face;
+  }
+  ~hb_ft_locked_face_t ()
+  {
+    if (item)
+      ft_font->face_pool->release (item);
+    else
+      ft_font->lock.unlock ();
+  }
+
+  hb_ft_locked_face_t (const hb_ft_locked_face_t &) = delete;
+  hb_ft_locked_face_t &operator= (const hb_ft_locked_face_t &) = delete;
+
+  FT_Face ft_face;
+
+  private:
+  const hb_ft_font_t *ft_font;
+  hb_ft_face_pool_t::item_t *item = nullptr;
+};
+
+
 /**
  * hb_ft_font_set_load_flags:
  * @font: #hb_font_t to work upon
@@ -275,6 +492,62 @@ hb_ft_font_get_load_flags (hb_font_t *font)
   return ft_font->load_flags;
 }
 
+/**
+ * hb_ft_font_set_face_pool_size:
+ * @font: #hb_font_t to work upon
+ * @pool_size: maximum number of extra FT_Face objects to open
+ *
+ * Lets the FreeType font functions of @font use up to @pool_size
+ * FT_Face objects besides the one @font was created with.
+ *
+ * All FreeType font functions of a font share its FT_Face, so they
+ * hold a lock on it while they run, and using the font from several
+ * threads at once, eg. to shape with it, makes them wait on each
+ * other.  With a pool, each call instead takes a face that is not in
+ * use, opening a new one over the same font data as needed, and only
+ * falls back to waiting on the original face when all @pool_size faces
+ * are busy.  The advance cache of @font is shared by all faces.
+ *
+ * So that results do not depend on which face serves a call, faces in
+ * the pool are set up like the original FT_Face: with its size and
+ * transform, including ones set on it directly, and the variations of
+ * @font.  The original FT_Face is not changed.  After changing it
+ * directly, such as through hb_ft_font_lock_face(), call
+ * hb_ft_font_changed() for the pool to pick the changes up.  Passing
+ * zero for @pool_size closes the pool.
+ *
+ * This function works with #hb_font_t objects created by
+ * hb_ft_font_create(), hb_ft_font_create_referenced(), or
+ * hb_ft_font_set_funcs(), for fonts whose #hb_face_t gives access to the
+ * whole font data.  It is not thread-safe.
+ *
+ * Return value: `true` if the pool was set up or closed, `false`
+ * otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_ft_font_set_face_pool_size (hb_font_t    *font,
+			       unsigned int  pool_size)
+{
+  if (hb_object_is_immutable (font))
+    return false;
+
+  if (unlikely (font->destroy != (hb_destroy_func_t) _hb_ft_font_destroy))
+    return false;
+
+  hb_ft_font_t *ft_font = (hb_ft_font_t *) font->user_data;
+
+  hb_ft_face_pool_t::destroy (ft_font->face_pool);
+  ft_font->face_pool = nullptr;
+
+  if (!pool_size)
+    return true;
+
+  ft_font->face_pool = hb_ft_face_pool_t::create (font, ft_font, pool_size);
+  return ft_font->face_pool != nullptr;
+}
+
 /**
  * hb_ft_font_get_ft_face: (skip)
  * @font: #hb_font_t to work upon
@@ -381,8 +654,9 @@ hb_ft_get_nominal_glyph (hb_font_t *font,
 			 void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  unsigned int g = FT_Get_Char_Index (ft_font->ft_face, unicode);
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
+  unsigned int g = FT_Get_Char_Index (ft_face, unicode);
 
   if (unlikely (!g))
   {
@@ -396,14 +670,14 @@ hb_ft_get_nominal_glyph (hb_font_t *font,
 	   * Windows seems to do, and that's hinted about at:
 	   * https://docs.microsoft.com/en-us/typography/opentype/spec/recom
 	   * under "Non-Standard (Symbol) Fonts". */
-	  g = FT_Get_Char_Index (ft_font->ft_face, 0xF000u + unicode);
+	  g = FT_Get_Char_Index (ft_face, 0xF000u + unicode);
 	break;
 #ifndef HB_NO_OT_SHAPER_ARABIC_FALLBACK
       case OT::OS2::font_page_t::FONT_PAGE_SIMP_ARABIC:
-	g = FT_Get_Char_Index (ft_font->ft_face, _hb_arabic_pua_simp_map (unicode));
+	g = FT_Get_Char_Index (ft_face, _hb_arabic_pua_simp_map (unicode));
 	break;
       case OT::OS2::font_page_t::FONT_PAGE_TRAD_ARABIC:
-	g = FT_Get_Char_Index (ft_font->ft_face, _hb_arabic_pua_trad_map (unicode));
+	g = FT_Get_Char_Index (ft_face, _hb_arabic_pua_trad_map (unicode));
 	break;
 #endif
       default:
@@ -421,7 +695,7 @@ hb_ft_get_nominal_glyph (hb_font_t *font,
 }
 
 static unsigned int
-hb_ft_get_nominal_glyphs (hb_font_t *font HB_UNUSED,
+hb_ft_get_nominal_glyphs (hb_font_t *font,
 			  void *font_data,
 			  unsigned int count,
 			  const hb_codepoint_t *first_unicode,
@@ -431,10 +705,11 @@ hb_ft_get_nominal_glyphs (hb_font_t *font HB_UNUSED,
 			  void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
   unsigned int done;
   for (done = 0;
-       done < count && (*first_glyph = FT_Get_Char_Index (ft_font->ft_face, *first_unicode));
+       done < count && (*first_glyph = FT_Get_Char_Index (ft_face, *first_unicode));
        done++)
   {
     first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
@@ -447,7 +722,7 @@ hb_ft_get_nominal_glyphs (hb_font_t *font HB_UNUSED,
 
 
 static hb_bool_t
-hb_ft_get_variation_glyph (hb_font_t *font HB_UNUSED,
+hb_ft_get_variation_glyph (hb_font_t *font,
 			   void *font_data,
 			   hb_codepoint_t unicode,
 			   hb_codepoint_t variation_selector,
@@ -455,8 +730,8 @@ hb_ft_get_variation_glyph (hb_font_t *font HB_UNUSED,
 			   void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  unsigned int g = FT_Face_GetCharVariantIndex (ft_font->ft_face, unicode, variation_selector);
+  hb_ft_locked_face_t locked (font, ft_font);
+  unsigned int g = FT_Face_GetCharVariantIndex (locked.ft_face, unicode, variation_selector);
 
   if (unlikely (!g))
     return false;
@@ -477,8 +752,8 @@ hb_ft_get_glyph_h_advances (hb_font_t* font, void* font_data,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
   int load_flags = ft_font->load_flags;
   float x_mult;
 #ifdef HAVE_FT_GET_TRANSFORM
@@ -501,7 +776,7 @@ hb_ft_get_glyph_h_advances (hb_font_t* font, void* font_data,
     hb_codepoint_t glyph = *first_glyph;
 
     unsigned int cv;
-    if (ft_font->advance_cache.get (glyph, &cv))
+    if (ft_font->advance_cache && ft_font->advance_cache->get (glyph, &cv))
       v = cv;
     else
     {
@@ -510,7 +785,8 @@ hb_ft_get_glyph_h_advances (hb_font_t* font, void* font_data,
        * for variable-set fonts if x_scale is negative! */
       v = abs (v);
       v = (int) (v * x_mult + (1<<9)) >> 10;
-      ft_font->advance_cache.set (glyph, v);
+      if (ft_font->advance_cache)
+	ft_font->advance_cache->set (glyph, v);
     }
 
     *first_advance = v;
@@ -529,14 +805,15 @@ hb_ft_get_glyph_v_advance (hb_font_t *font,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
   FT_Fixed v;
   float y_mult;
 #ifdef HAVE_FT_GET_TRANSFORM
   if (ft_font->transform)
   {
     FT_Matrix matrix;
-    FT_Get_Transform (ft_font->ft_face, &matrix, nullptr);
+    FT_Get_Transform (ft_face, &matrix, nullptr);
     y_mult = sqrtf ((float)matrix.yx * matrix.yx + (float)matrix.yy * matrix.yy) / 65536.f;
     y_mult *= font->y_scale < 0 ? -1 : +1;
   }
@@ -546,7 +823,7 @@ hb_ft_get_glyph_v_advance (hb_font_t *font,
     y_mult = font->y_scale < 0 ? -1 : +1;
   }
 
-  if (unlikely (FT_Get_Advance (ft_font->ft_face, glyph, ft_font->load_flags | FT_LOAD_VERTICAL_LAYOUT, &v)))
+  if (unlikely (FT_Get_Advance (ft_face, glyph, ft_font->load_flags | FT_LOAD_VERTICAL_LAYOUT, &v)))
     return 0;
 
   /* Note: FreeType's vertical metrics grows downward while other FreeType coordinates
@@ -569,8 +846,8 @@ hb_ft_get_glyph_v_origin (hb_font_t *font,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
   float x_mult, y_mult;
 #ifdef HAVE_FT_GET_TRANSFORM
   if (ft_font->transform)
@@ -615,11 +892,11 @@ hb_ft_get_glyph_h_kerning (hb_font_t *font,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
+  hb_ft_locked_face_t locked (font, ft_font);
   FT_Vector kerningv;
 
   FT_Kerning_Mode mode = font->x_ppem ? FT_KERNING_DEFAULT : FT_KERNING_UNFITTED;
-  if (FT_Get_Kerning (ft_font->ft_face, left_glyph, right_glyph, mode, &kerningv))
+  if (FT_Get_Kerning (locked.ft_face, left_glyph, right_glyph, mode, &kerningv))
     return 0;
 
   return kerningv.x;
@@ -675,8 +952,8 @@ hb_ft_get_glyph_extents (hb_font_t *font,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
   float x_mult, y_mult;
 
 #ifdef HAVE_FT_GET_TRANSFORM
@@ -726,8 +1003,8 @@ hb_ft_get_glyph_contour_point (hb_font_t *font HB_UNUSED,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
 
   if (unlikely (FT_Load_Glyph (ft_face, glyph, ft_font->load_flags)))
       return false;
@@ -745,15 +1022,15 @@ hb_ft_get_glyph_contour_point (hb_font_t *font HB_UNUSED,
 }
 
 static hb_bool_t
-hb_ft_get_glyph_name (hb_font_t *font HB_UNUSED,
+hb_ft_get_glyph_name (hb_font_t *font,
 		      void *font_data,
 		      hb_codepoint_t glyph,
 		      char *name, unsigned int size,
 		      void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
 
   hb_bool_t ret = !FT_Get_Glyph_Name (ft_face, glyph, name, size);
   if (ret && (size && !*name))
@@ -763,15 +1040,15 @@ hb_ft_get_glyph_name (hb_font_t *font HB_UNUSED,
 }
 
 static hb_bool_t
-hb_ft_get_glyph_from_name (hb_font_t *font HB_UNUSED,
+hb_ft_get_glyph_from_name (hb_font_t *font,
 			   void *font_data,
 			   const char *name, int len, /* -1 means nul-terminated */
 			   hb_codepoint_t *glyph,
 			   void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
 
   if (len < 0)
     *glyph = FT_Get_Name_Index (ft_face, (FT_String *) name);
@@ -797,7 +1074,7 @@ hb_ft_get_glyph_from_name (hb_font_t *font HB_UNUSED,
 }
 
 static hb_bool_t
-hb_ft_get_font_h_extents (hb_font_t *font HB_UNUSED,
+hb_ft_get_font_h_extents (hb_font_t *font,
 			  void *font_data,
 			  hb_font_extents_t *metrics,
 			  void *user_data HB_UNUSED)
@@ -805,8 +1082,8 @@ hb_ft_get_font_h_extents (hb_font_t *font HB_UNUSED,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
   float y_mult;
 #ifdef HAVE_FT_GET_TRANSFORM
   if (ft_font->transform)
@@ -897,8 +1174,8 @@ hb_ft_draw_glyph_or_fail (hb_font_t *font,
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
   _hb_ft_hb_font_check_changed (font, ft_font);
 
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_locked_face_t locked (font, ft_font);
+  FT_Face ft_face = locked.ft_face;
 
   if (unlikely (FT_Load_Glyph (ft_face, glyph,
 			       FT_LOAD_NO_BITMAP | ft_font->load_flags)))
@@ -1386,8 +1663,11 @@ hb_ft_font_changed (hb_font_t *font)
   }
 #endif
 
-  ft_font->advance_cache.clear ();
+  if (ft_font->advance_cache)
+    ft_font->advance_cache->clear ();
   ft_font->cached_serial = font->serial;
+  if (ft_font->face_pool)
+    ft_font->face_pool->generation.inc ();
 }
 
 /**
@@ -1465,6 +1745,19 @@ static FT_MemoryRec_ m =
   _hb_ft_realloc
 };
 
+static FT_Library
+_hb_ft_new_library ()
+{
+  FT_Library l;
+  if (FT_New_Library (&m, &l))
+    return nullptr;
+
+  FT_Add_Default_Modules (l);
+  FT_Set_Default_Properties (l);
+
+  return l;
+}
+
 static inline void free_static_ft_library ();
 
 static struct hb_ft_library_lazy_loader_t : hb_lazy_loader_t<hb_remove_pointer<FT_Library>,
@@ -1472,13 +1765,10 @@ static struct hb_ft_library_lazy_loader_t : hb_lazy_loader_t<hb_remove_pointer<F
 {
   static FT_Library create ()
   {
-    FT_Library l;
-    if (FT_New_Library (&m, &l))
+    FT_Library l = _hb_ft_new_library ();
+    if (unlikely (!l))
       return nullptr;
 
-    FT_Add_Default_Modules (l);
-    FT_Set_Default_Properties (l);
-
     hb_atexit (free_static_ft_library);
 
     return l;
@@ -1722,7 +2012,8 @@ hb_ft_font_set_funcs (hb_font_t *font)
   _hb_ft_font_set_funcs (font, ft_face, true);
   hb_ft_font_set_load_flags (font, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING);
 
-  _hb_ft_hb_font_changed (font, ft_face);
+  if (_hb_ft_hb_font_changed (font, ft_face))
+    ((hb_ft_font_t *) font->user_data)->transform = true;
 }
 
 #endif
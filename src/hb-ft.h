@@ -129,6 +129,10 @@ hb_ft_font_set_load_flags (hb_font_t *font, int load_flags);
 HB_EXTERN int
 hb_ft_font_get_load_flags (hb_font_t *font);
 
+HB_EXTERN hb_bool_t
+hb_ft_font_set_face_pool_size (hb_font_t    *font,
+			       unsigned int  pool_size);
+
 /* Call when size or variations settings on underlying FT_Face changed,
  * and you want to update the hb_font_t from it. */
 HB_EXTERN void
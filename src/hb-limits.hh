@@ -96,6 +96,10 @@
 #define HB_VAR_COMPOSITE_MAX_AXES 4096
 #endif
 
+#ifndef HB_VAR_STORE_MAX_CACHED_SCALARS
+#define HB_VAR_STORE_MAX_CACHED_SCALARS (1u << 20)
+#endif
+
 #ifndef HB_GLYF_MAX_POINTS
 #define HB_GLYF_MAX_POINTS 200000
 #endif
@@ -104,6 +108,10 @@
 #define HB_CFF_MAX_OPS 200000
 #endif
 
+#ifndef HB_CFF_MAX_FLAT_CHARSTRING_LENGTH
+#define HB_CFF_MAX_FLAT_CHARSTRING_LENGTH 65535
+#endif
+
 #ifndef HB_MAX_COMPOSITE_OPERATIONS_PER_GLYPH
 #define HB_MAX_COMPOSITE_OPERATIONS_PER_GLYPH 64
 #endif
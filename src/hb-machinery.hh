@@ -235,6 +235,13 @@ struct hb_lazy_loader_t : hb_data_wrapper_t<Data, WheresData>
     return this->instance.get_relaxed ();
   }
 
+  /* Does not load; nullptr if not loaded, or if loading failed. */
+  Stored * get_stored_if_loaded () const
+  {
+    Stored *p = this->instance.get_acquire ();
+    return p == Funcs::get_null () ? nullptr : p;
+  }
+
   bool cmpexch (Stored *current, Stored *value) const
   {
     /* This function can only be safely called directly if no
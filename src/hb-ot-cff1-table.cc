@@ -393,12 +393,12 @@ bool _get_bounds (const OT::cff1::accelerator_t *cff, hb_codepoint_t glyph, boun
   if (unlikely (!cff->is_valid () || (glyph >= cff->num_glyphs))) return false;
 
   unsigned int fd = cff->fdSelect->get_fd (glyph);
-  const hb_ubytes_t str = (*cff->charStrings)[glyph];
-  cff1_cs_interp_env_t env (str, *cff, fd);
+  CFF::cs_flat_cache_t::lookup_t cs (cff->get_flat_cache (), glyph, (*cff->charStrings)[glyph]);
+  cff1_cs_interp_env_t env (cs.str, *cff, fd);
   env.set_in_seac (in_seac);
   cff1_cs_interpreter_t<cff1_cs_opset_extents_t, cff1_extents_param_t> interp (env);
   cff1_extents_param_t param (cff);
-  if (unlikely (!interp.interpret (param))) return false;
+  if (unlikely (!cs.interpret (interp, param))) return false;
   bounds = param.bounds;
   return true;
 }
@@ -540,12 +540,12 @@ bool _get_path (const OT::cff1::accelerator_t *cff, hb_font_t *font, hb_codepoin
   if (unlikely (!cff->is_valid () || (glyph >= cff->num_glyphs))) return false;
 
   unsigned int fd = cff->fdSelect->get_fd (glyph);
-  const hb_ubytes_t str = (*cff->charStrings)[glyph];
-  cff1_cs_interp_env_t env (str, *cff, fd);
+  CFF::cs_flat_cache_t::lookup_t cs (cff->get_flat_cache (), glyph, (*cff->charStrings)[glyph]);
+  cff1_cs_interp_env_t env (cs.str, *cff, fd);
   env.set_in_seac (in_seac);
   cff1_cs_interpreter_t<cff1_cs_opset_path_t, cff1_path_param_t> interp (env);
   cff1_path_param_t param (cff, font, draw_session, delta);
-  if (unlikely (!interp.interpret (param))) return false;
+  if (unlikely (!cs.interpret (interp, param))) return false;
 
   /* Let's end the path specially since it is called inside seac also */
   param.end_path ();
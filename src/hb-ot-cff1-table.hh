@@ -1364,6 +1364,15 @@ struct cff1
       glyph_names.set_relaxed (nullptr);
 
       if (!is_valid ()) return;
+
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      /* Flattening only pays off if there are subroutines to inline. */
+      use_flat_cache = globalSubrs->count;
+      for (const auto &priv : privateDicts)
+	use_flat_cache = use_flat_cache || priv.localSubrs->count;
+      flat_cache.init (num_glyphs);
+#endif
+
       if (is_CID ()) return;
     }
     ~accelerator_t ()
@@ -1466,7 +1475,49 @@ struct cff1
     HB_INTERNAL bool get_extents (hb_font_t *font, hb_codepoint_t glyph, hb_glyph_extents_t *extents) const;
     HB_INTERNAL bool get_path (hb_font_t *font, hb_codepoint_t glyph, hb_draw_session_t &draw_session) const;
 
+    const CFF::cs_flat_cache_t *get_flat_cache () const
+    {
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      return use_flat_cache ? &flat_cache : nullptr;
+#else
+      return nullptr;
+#endif
+    }
+
+    unsigned get_memory_usage () const
+    {
+      unsigned size = sizeof (*this);
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      size += flat_cache.get_memory_usage ();
+#endif
+      hb_sorted_vector_t<gname_t> *names = glyph_names.get_acquire ();
+      if (names)
+	size += sizeof (*names) + names->get_size ();
+      return size;
+    }
+
+    /* Frees the flattened charstrings and the glyph-name index.  Must
+     * not run concurrently with any other use of the face. */
+    void trim () const
+    {
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      flat_cache.clear ();
+#endif
+      hb_sorted_vector_t<gname_t> *names = glyph_names.get_relaxed ();
+      glyph_names.set_relaxed (nullptr);
+      if (names)
+      {
+	names->fini ();
+	hb_free (names);
+      }
+    }
+
     private:
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+    mutable CFF::cs_flat_cache_t flat_cache;
+    bool use_flat_cache = false;
+#endif
+
     struct gname_t
     {
       hb_bytes_t	name;
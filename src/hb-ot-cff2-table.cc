@@ -119,11 +119,11 @@ bool OT::cff2::accelerator_t::get_extents_at (hb_font_t *font,
   if (unlikely (!is_valid () || (glyph >= num_glyphs))) return false;
 
   unsigned int fd = fdSelect->get_fd (glyph);
-  const hb_ubytes_t str = (*charStrings)[glyph];
-  cff2_cs_interp_env_t<number_t> env (str, *this, fd, coords.arrayZ, coords.length);
+  CFF::cs_flat_cache_t::lookup_t cs (get_flat_cache (), glyph, (*charStrings)[glyph]);
+  cff2_cs_interp_env_t<number_t> env (cs.str, *this, fd, coords.arrayZ, coords.length);
   cff2_cs_interpreter_t<cff2_cs_opset_extents_t, cff2_extents_param_t, number_t> interp (env);
   cff2_extents_param_t  param;
-  if (unlikely (!interp.interpret (param))) return false;
+  if (unlikely (!cs.interpret (interp, param))) return false;
 
   if (param.min_x >= param.max_x)
   {
@@ -215,11 +215,11 @@ bool OT::cff2::accelerator_t::get_path_at (hb_font_t *font, hb_codepoint_t glyph
   if (unlikely (!is_valid () || (glyph >= num_glyphs))) return false;
 
   unsigned int fd = fdSelect->get_fd (glyph);
-  const hb_ubytes_t str = (*charStrings)[glyph];
-  cff2_cs_interp_env_t<number_t> env (str, *this, fd, coords.arrayZ, coords.length);
+  CFF::cs_flat_cache_t::lookup_t cs (get_flat_cache (), glyph, (*charStrings)[glyph]);
+  cff2_cs_interp_env_t<number_t> env (cs.str, *this, fd, coords.arrayZ, coords.length);
   cff2_cs_interpreter_t<cff2_cs_opset_path_t, cff2_path_param_t, number_t> interp (env);
   cff2_path_param_t param (font, draw_session);
-  if (unlikely (!interp.interpret (param))) return false;
+  if (unlikely (!cs.interpret (interp, param))) return false;
   return true;
 }
 
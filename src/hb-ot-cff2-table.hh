@@ -138,6 +138,77 @@ struct CFF2ItemVariationStore
   DEFINE_SIZE_MIN (2 + ItemVariationStore::min_size);
 };
 
+/* Region scalars of a CFF2 variation store at one set of normalized
+ * coordinates.  Scalars are computed lazily for each vsindex, and reused
+ * across charstrings until the coordinates change. */
+struct cff2_region_scalars_t
+{
+  static cff2_region_scalars_t *create ()
+  {
+    cff2_region_scalars_t *scalars = (cff2_region_scalars_t *) hb_calloc (1, sizeof (cff2_region_scalars_t));
+    if (unlikely (!scalars))
+      return nullptr;
+    new (scalars) cff2_region_scalars_t ();
+    return scalars;
+  }
+
+  static void destroy (cff2_region_scalars_t *scalars)
+  {
+    if (!scalars)
+      return;
+    scalars->~cff2_region_scalars_t ();
+    hb_free (scalars);
+  }
+
+  /* Returns the region scalars of vsindex ivs; nullptr on allocation failure. */
+  const hb_vector_t<float> *get (const CFF2ItemVariationStore &varStore, unsigned ivs,
+				 const int *coords_, unsigned num_coords)
+  {
+    hb_array_t<const int> new_coords (coords_, num_coords);
+    if (!(hb_array_t<const int> (coords) == new_coords))
+    {
+      for (auto &item : items)
+	item.valid = false;
+      coords.reset ();
+      coords.extend (new_coords);
+      if (unlikely (coords.in_error ()))
+      {
+	coords.reset ();
+	return nullptr;
+      }
+    }
+
+    if (ivs >= varStore.varStore.get_sub_table_count ())
+      return &empty;
+
+    if (ivs >= items.length && unlikely (!items.resize (ivs + 1)))
+      return nullptr;
+
+    item_t &item = items.arrayZ[ivs];
+    if (!item.valid)
+    {
+      unsigned region_count = varStore.varStore.get_region_index_count (ivs);
+      if (unlikely (!item.values.resize_exact (region_count)))
+	return nullptr;
+      varStore.varStore.get_region_scalars (ivs, coords_, num_coords,
+					    item.values.arrayZ, region_count);
+      item.valid = true;
+    }
+    return &item.values;
+  }
+
+  protected:
+  struct item_t
+  {
+    bool valid;
+    hb_vector_t<float> values;
+  };
+
+  hb_vector_t<int> coords;
+  hb_vector_t<item_t> items;
+  hb_vector_t<float> empty;
+};
+
 struct cff2_top_dict_values_t : top_dict_values_t<>
 {
   void init ()
@@ -483,12 +554,9 @@ struct cff2
       hb_blob_destroy (blob);
       blob = nullptr;
 
-      auto *scalars = cached_scalars_vector.get_acquire ();
-      if (scalars && cached_scalars_vector.cmpexch (scalars, nullptr))
-      {
-	scalars->fini ();
-	hb_free (scalars);
-      }
+      auto *scalars = cached_region_scalars.get_acquire ();
+      if (scalars && cached_region_scalars.cmpexch (scalars, nullptr))
+	cff2_region_scalars_t::destroy (scalars);
     }
 
     hb_vector_t<uint16_t> *create_glyph_to_sid_map () const
@@ -516,14 +584,25 @@ struct cff2
     hb_vector_t<cff2_font_dict_values_t>     fontDicts;
     hb_vector_t<PRIVDICTVAL>  privateDicts;
 
-    mutable hb_atomic_t<hb_vector_t<float> *> cached_scalars_vector;
+    mutable hb_atomic_t<cff2_region_scalars_t *> cached_region_scalars;
 
     unsigned int	      num_glyphs = 0;
   };
 
   struct accelerator_t : accelerator_templ_t<cff2_private_dict_opset_t, cff2_private_dict_values_t>
   {
-    accelerator_t (hb_face_t *face) : accelerator_templ_t (face) {}
+    accelerator_t (hb_face_t *face) : accelerator_templ_t (face)
+    {
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      if (!is_valid ()) return;
+
+      /* Flattening only pays off if there are subroutines to inline. */
+      use_flat_cache = globalSubrs->count;
+      for (const auto &priv : privateDicts)
+	use_flat_cache = use_flat_cache || priv.localSubrs->count;
+      flat_cache.init (num_glyphs);
+#endif
+    }
 
     HB_INTERNAL bool get_extents (hb_font_t *font,
 				  hb_codepoint_t glyph,
@@ -534,6 +613,39 @@ struct cff2
 				     hb_array_t<const int> coords) const;
     HB_INTERNAL bool get_path (hb_font_t *font, hb_codepoint_t glyph, hb_draw_session_t &draw_session) const;
     HB_INTERNAL bool get_path_at (hb_font_t *font, hb_codepoint_t glyph, hb_draw_session_t &draw_session, hb_array_t<const int> coords) const;
+
+    const CFF::cs_flat_cache_t *get_flat_cache () const
+    {
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      return use_flat_cache ? &flat_cache : nullptr;
+#else
+      return nullptr;
+#endif
+    }
+
+    unsigned get_memory_usage () const
+    {
+      unsigned size = sizeof (*this);
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      size += flat_cache.get_memory_usage ();
+#endif
+      return size;
+    }
+
+    /* Frees the flattened charstrings.  Must not run concurrently with
+     * any other use of the face. */
+    void trim () const
+    {
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+      flat_cache.clear ();
+#endif
+    }
+
+    private:
+#ifndef HB_NO_CFF_CHARSTRING_CACHE
+    mutable CFF::cs_flat_cache_t flat_cache;
+    bool use_flat_cache = false;
+#endif
   };
 
   struct accelerator_subset_t : accelerator_templ_t<cff2_private_dict_opset_subset_t, cff2_private_dict_values_subset_t>
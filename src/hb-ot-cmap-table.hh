@@ -39,6 +39,15 @@
  */
 #define HB_OT_TAG_cmap HB_TAG('c','m','a','p')
 
+/* Memory cap, per face, for the direct-mapped cmap index. */
+#ifndef HB_OT_FONT_CMAP_DIRECT_MAP_MAX_BYTES
+#define HB_OT_FONT_CMAP_DIRECT_MAP_MAX_BYTES (256 * 1024)
+#endif
+/* Cache misses in a page of 256 codepoints before it is indexed. */
+#ifndef HB_OT_FONT_CMAP_DIRECT_MAP_THRESHOLD
+#define HB_OT_FONT_CMAP_DIRECT_MAP_THRESHOLD 16
+#endif
+
 namespace OT {
 
 static inline uint8_t unicode_to_macroman (hb_codepoint_t u)
@@ -2017,6 +2026,142 @@ struct cmap
     using cache_t = hb_cache_t<21, 19>;
     static_assert (sizeof (cache_t) == 1024, "");
 
+#ifndef HB_NO_OT_FONT_CMAP_DIRECT_MAP
+    /* A direct-mapped codepoint-to-glyph index, built lazily one page
+     * of 256 codepoints at a time, once lookups in that page have
+     * missed the cache often enough to be worth it.  Published pages
+     * are immutable, and shared by all threads using the face.
+     *
+     * In a page, 0 marks unmapped codepoints, and 0xFFFF those we can't
+     * represent (glyph 0, or glyphs that don't fit 16 bits); those take
+     * the slow path. */
+    struct direct_map_t
+    {
+      static constexpr unsigned PAGE_BITS = 8;
+      static constexpr unsigned PAGE_SIZE = 1u << PAGE_BITS;
+      static constexpr unsigned PLANE_PAGES = 0x10000u >> PAGE_BITS;
+      static constexpr unsigned NUM_PLANES = 17;
+
+      struct page_t
+      {
+	uint16_t glyphs[PAGE_SIZE];
+      };
+      struct plane_t
+      {
+	hb_atomic_t<const page_t *> pages[PLANE_PAGES];
+	hb_atomic_t<unsigned short> misses[PLANE_PAGES];
+      };
+
+      ~direct_map_t ()
+      {
+	for (auto &p : planes)
+	{
+	  plane_t *plane = p.get_relaxed ();
+	  if (!plane)
+	    continue;
+	  for (auto &page : plane->pages)
+	    hb_free ((void *) page.get_relaxed ());
+	  hb_free (plane);
+	}
+      }
+
+      static constexpr unsigned UNMAPPED = 0;
+      static constexpr unsigned SLOW = 0xFFFFu;
+
+      /* Returns UNMAPPED, SLOW, or the glyph. */
+      unsigned get (hb_codepoint_t unicode) const
+      {
+	unsigned p = unicode >> 16;
+	if (unlikely (p >= NUM_PLANES))
+	  return SLOW;
+	const plane_t *plane = planes[p].get_acquire ();
+	if (!plane)
+	  return SLOW;
+	const page_t *page = plane->pages[(unicode >> PAGE_BITS) & (PLANE_PAGES - 1)].get_acquire ();
+	if (!page)
+	  return SLOW;
+	return page->glyphs[unicode & (PAGE_SIZE - 1)];
+      }
+
+      /* Records a lookup of unicode that missed the fast paths; builds
+       * its page, using get_glyph, when that page gets hot. */
+      template <typename GetGlyph>
+      void miss (hb_codepoint_t unicode, GetGlyph get_glyph) const
+      {
+	unsigned p = unicode >> 16;
+	if (unlikely (p >= NUM_PLANES))
+	  return;
+
+	plane_t *plane = planes[p].get_acquire ();
+	if (unlikely (!plane))
+	{
+	  if (!reserve (sizeof (plane_t)))
+	    return;
+	  plane = (plane_t *) hb_calloc (1, sizeof (plane_t));
+	  if (unlikely (!plane))
+	  {
+	    memory.add (-(int) sizeof (plane_t));
+	    return;
+	  }
+	  if (unlikely (!planes[p].cmpexch (nullptr, plane)))
+	  {
+	    hb_free (plane);
+	    memory.add (-(int) sizeof (plane_t));
+	    plane = planes[p].get_acquire ();
+	  }
+	}
+
+	/* Only the thread that brings the count to the threshold builds
+	 * the page; counting stops there. */
+	unsigned i = (unicode >> PAGE_BITS) & (PLANE_PAGES - 1);
+	auto &misses = plane->misses[i];
+	if (misses.get_relaxed () >= HB_OT_FONT_CMAP_DIRECT_MAP_THRESHOLD ||
+	    misses.inc () != HB_OT_FONT_CMAP_DIRECT_MAP_THRESHOLD - 1)
+	  return;
+
+	if (!reserve (sizeof (page_t)))
+	  return;
+	page_t *page = (page_t *) hb_malloc (sizeof (page_t));
+	if (unlikely (!page))
+	{
+	  memory.add (-(int) sizeof (page_t));
+	  return;
+	}
+	hb_codepoint_t start = unicode & ~(PAGE_SIZE - 1);
+	for (unsigned j = 0; j < PAGE_SIZE; j++)
+	{
+	  hb_codepoint_t g;
+	  if (!get_glyph (start + j, &g))
+	    page->glyphs[j] = UNMAPPED;
+	  else
+	    page->glyphs[j] = g && g < SLOW ? g : SLOW;
+	}
+	if (unlikely (!plane->pages[i].cmpexch (nullptr, page)))
+	{
+	  hb_free (page);
+	  memory.add (-(int) sizeof (page_t));
+	}
+      }
+
+      unsigned get_memory () const { return memory.get_relaxed (); }
+
+      private:
+
+      bool reserve (unsigned size) const
+      {
+	if ((unsigned) memory.add ((int) size) + size > HB_OT_FONT_CMAP_DIRECT_MAP_MAX_BYTES)
+	{
+	  memory.add (-(int) size);
+	  return false;
+	}
+	return true;
+      }
+
+      mutable hb_atomic_t<plane_t *> planes[NUM_PLANES];
+      mutable hb_atomic_t<int> memory;
+    };
+#endif
+
     accelerator_t (hb_face_t *face)
     {
       this->table = hb_sanitize_context_t ().reference_table<cmap> (face);
@@ -2106,6 +2251,26 @@ struct cmap
         *glyph = v;
 	return true;
       }
+#endif
+      return _uncached_get (unicode, glyph);
+    }
+
+    /* Separate, to keep the cache-hit path above lean. */
+    bool _uncached_get (hb_codepoint_t unicode,
+			hb_codepoint_t *glyph) const
+    {
+#ifndef HB_NO_OT_FONT_CMAP_DIRECT_MAP
+      unsigned g = direct_map.get (unicode);
+      if (g != direct_map_t::SLOW)
+      {
+	if (g == direct_map_t::UNMAPPED)
+	  return false;
+	*glyph = g;
+#ifndef HB_NO_OT_FONT_CMAP_CACHE
+	cache->set (unicode, g);
+#endif
+	return true;
+      }
 #endif
       bool ret  = this->get_glyph_funcZ (this->get_glyph_data, unicode, glyph);
 
@@ -2113,6 +2278,10 @@ struct cmap
       if (ret)
         cache->set (unicode, *glyph);
 #endif
+#ifndef HB_NO_OT_FONT_CMAP_DIRECT_MAP
+      direct_map.miss (unicode, [this] (hb_codepoint_t u, hb_codepoint_t *g)
+		       { return this->get_glyph_funcZ (this->get_glyph_data, u, g); });
+#endif
 
       return ret;
     }
@@ -2234,6 +2403,9 @@ struct cmap
 #ifndef HB_NO_OT_FONT_CMAP_CACHE
     cache_t *cache = nullptr;
 #endif
+#ifndef HB_NO_OT_FONT_CMAP_DIRECT_MAP
+    direct_map_t direct_map;
+#endif
 
     public:
     hb_blob_ptr_t<cmap> table;
@@ -25,6 +25,7 @@
  */
 
 #include "hb-ot-face.hh"
+#include "hb-face-snapshot.hh"
 
 #include "hb-ot-cmap-table.hh"
 #include "hb-ot-glyf-table.hh"
@@ -42,9 +43,28 @@
 #include "hb-ot-layout-gdef-table.hh"
 #include "hb-ot-layout-gsub-table.hh"
 #include "hb-ot-layout-gpos-table.hh"
+#include "hb-ot-layout-gsubgpos.hh"
 #include "hb-ot-var-varc-table.hh"
 #include "hb-aat-layout-kerx-table.hh"
 #include "hb-aat-layout-morx-table.hh"
+#include "hb-aat-layout-ankr-table.hh"
+#include "hb-aat-layout-feat-table.hh"
+#include "hb-aat-layout-trak-table.hh"
+#include "hb-aat-ltag-table.hh"
+#include "hb-ot-head-table.hh"
+#include "hb-ot-maxp-table.hh"
+#include "hb-ot-hhea-table.hh"
+#include "hb-ot-os2-table.hh"
+#include "hb-ot-stat-table.hh"
+#include "hb-ot-vorg-table.hh"
+#include "hb-ot-layout-base-table.hh"
+#include "hb-ot-math-table.hh"
+#include "hb-ot-var-avar-table.hh"
+#include "hb-ot-var-cvar-table.hh"
+#include "hb-ot-var-fvar-table.hh"
+#include "hb-ot-var-gvar-table.hh"
+#include "hb-ot-var-mvar-table.hh"
+#include "OT/Color/CPAL/CPAL.hh"
 
 
 void hb_ot_face_t::init0 (hb_face_t *face)
@@ -60,3 +80,292 @@ void hb_ot_face_t::fini ()
 #include "hb-ot-face-table-list.hh"
 #undef HB_OT_TABLE
 }
+
+
+/*
+ * Warm-up
+ */
+
+namespace OT {
+using Layout::GSUB;
+using Layout::GPOS;
+}
+
+struct hb_ot_face_loader_t
+{
+  hb_tag_t tag;
+  void (*load) (const hb_ot_face_t *table);
+};
+
+static const hb_ot_face_loader_t hb_ot_face_loaders[] =
+{
+#define HB_OT_TABLE(Namespace, Type) \
+  {Namespace::Type::tableTag, [] (const hb_ot_face_t *table) { table->Type.get_stored (); }},
+#include "hb-ot-face-table-list.hh"
+#undef HB_OT_TABLE
+};
+
+/* What shaping and the built-in font functions load. */
+static const hb_tag_t hb_ot_face_warm_up_default_tags[] =
+{
+  HB_TAG ('h','e','a','d'),
+  HB_TAG ('m','a','x','p'),
+  HB_TAG ('c','m','a','p'),
+  HB_TAG ('h','h','e','a'),
+  HB_TAG ('h','m','t','x'),
+  HB_TAG ('O','S','/','2'),
+  HB_TAG ('l','o','c','a'),
+  HB_TAG ('g','l','y','f'),
+  HB_TAG ('C','F','F',' '),
+  HB_TAG ('C','F','F','2'),
+  HB_TAG ('f','v','a','r'),
+  HB_TAG ('a','v','a','r'),
+  HB_TAG ('g','v','a','r'),
+  HB_TAG ('M','V','A','R'),
+  HB_TAG ('k','e','r','n'),
+  HB_TAG ('G','D','E','F'),
+  HB_TAG ('G','S','U','B'),
+  HB_TAG ('G','P','O','S'),
+  HB_TAG ('m','o','r','x'),
+  HB_TAG ('m','o','r','t'),
+  HB_TAG ('k','e','r','x'),
+  HB_TAG ('a','n','k','r'),
+  HB_TAG ('t','r','a','k'),
+};
+
+struct hb_ot_face_warm_up_t
+{
+  static void task (void *task_data, unsigned int index)
+  {
+    const hb_ot_face_warm_up_t *c = (const hb_ot_face_warm_up_t *) task_data;
+    hb_ot_face_loaders[c->loaders.arrayZ[index]].load (c->table);
+  }
+
+  const hb_ot_face_t *table;
+  hb_vector_t<unsigned> loaders; /* Indices into hb_ot_face_loaders. */
+};
+
+void hb_ot_face_t::warm_up (const hb_tag_t     *tags,
+			    unsigned int        count,
+			    hb_executor_func_t  executor,
+			    void               *executor_data) const
+{
+  if (!tags)
+  {
+    tags = hb_ot_face_warm_up_default_tags;
+    count = ARRAY_LENGTH (hb_ot_face_warm_up_default_tags);
+  }
+
+  /* Most tables need these to sanitize; load them up front, rather than
+   * have every task race to. */
+  face->get_num_glyphs ();
+  face->get_upem ();
+
+  hb_ot_face_warm_up_t c;
+  c.table = this;
+  for (unsigned i = 0; i < ARRAY_LENGTH (hb_ot_face_loaders); i++)
+    if (hb_array (tags, count).lfind (hb_ot_face_loaders[i].tag))
+      c.loaders.push (i);
+  if (unlikely (c.loaders.in_error ()))
+    return;
+
+  if (executor && c.loaders.length > 1)
+    executor (hb_ot_face_warm_up_t::task, &c, c.loaders.length, executor_data);
+  else
+    for (unsigned i = 0; i < c.loaders.length; i++)
+      hb_ot_face_warm_up_t::task (&c, i);
+}
+
+
+/*
+ * Accelerator snapshots; see hb-face-snapshot.hh.
+ */
+
+struct hb_ot_face_snapshot_writer_t
+{
+  hb_face_t *face;
+  hb_vector_t<hb_face_snapshot_section_t> sections;
+  hb_vector_t<char> data; /* Section contents, offsets from its start. */
+
+  /* Returns room for length zeroed bytes, 8-byte aligned. */
+  char *add_section (hb_tag_t tag, unsigned length)
+  {
+    unsigned offset = (data.length + 7) & ~7u;
+    if (unlikely (!data.resize (offset + length)))
+      return nullptr;
+
+    hb_face_snapshot_section_t *section = sections.push ();
+    section->tag = tag;
+    section->offset = offset;
+    section->length = length;
+    section->reserved = 0;
+    section->table_digest = hb_face_snapshot_table_digest (face, tag);
+    return data.arrayZ + offset;
+  }
+
+  template <typename accelerator_t>
+  void add_lookups (hb_tag_t tag, const accelerator_t &accel)
+  {
+    unsigned lookup_count = accel.lookup_count;
+    if (!lookup_count)
+      return;
+
+    hb_vector_t<hb_face_snapshot_subtable_t> subtables;
+    hb_vector_t<hb_array_t<const uint64_t>> bitmaps;
+    hb_vector_t<uint32_t> first_subtable;
+    unsigned bitmap_words = 0;
+    for (unsigned i = 0; i < lookup_count; i++)
+    {
+      first_subtable.push (subtables.length);
+      const OT::hb_ot_layout_lookup_accelerator_t *lookup = accel.get_accel (i);
+      if (unlikely (!lookup))
+	return;
+      for (unsigned j = 0; j < lookup->get_subtable_count (); j++)
+      {
+	hb_face_snapshot_subtable_t *subtable = subtables.push ();
+	auto bits = lookup->snapshot (j, subtable);
+	bitmaps.push (bits);
+	bitmap_words += bits.length;
+      }
+    }
+    first_subtable.push (subtables.length);
+    if (unlikely (subtables.in_error () || bitmaps.in_error () || first_subtable.in_error ()))
+      return;
+
+    unsigned subtables_offset = hb_face_snapshot_lookups_t::get_subtables_offset (lookup_count);
+    unsigned bitmaps_offset = subtables_offset + subtables.get_size ();
+    char *section = add_section (tag, bitmaps_offset + bitmap_words * sizeof (uint64_t));
+    if (unlikely (!section))
+      return;
+
+    auto *lookups = (hb_face_snapshot_lookups_t *) (void *) section;
+    lookups->lookup_count = lookup_count;
+    lookups->subtable_count = subtables.length;
+    hb_memcpy (lookups->first_subtable, first_subtable.arrayZ, first_subtable.get_size ());
+
+    auto *out = (hb_face_snapshot_subtable_t *) (void *) (section + subtables_offset);
+    unsigned offset = bitmaps_offset;
+    for (unsigned i = 0; i < subtables.length; i++)
+    {
+      out[i] = subtables.arrayZ[i];
+      if (!bitmaps.arrayZ[i].length)
+	continue;
+      out[i].bitmap_offset = offset;
+      hb_memcpy (section + offset, bitmaps.arrayZ[i].arrayZ, bitmaps.arrayZ[i].get_size ());
+      offset += bitmaps.arrayZ[i].get_size ();
+    }
+  }
+
+  void add_glyph_names (hb_tag_t tag, hb_array_t<const uint16_t> gids)
+  {
+    if (!gids.length)
+      return;
+
+    char *section = add_section (tag, sizeof (uint32_t) + gids.get_size ());
+    if (unlikely (!section))
+      return;
+
+    auto *names = (hb_face_snapshot_glyph_names_t *) (void *) section;
+    names->count = gids.length;
+    hb_memcpy (names->gids, gids.arrayZ, gids.get_size ());
+  }
+
+  hb_blob_t *serialize ()
+  {
+    if (unlikely (sections.in_error () || data.in_error ()))
+      return hb_blob_get_empty ();
+
+    unsigned data_offset = sizeof (hb_face_snapshot_header_t) + sections.get_size ();
+    unsigned length = data_offset + data.length;
+    char *buf = (char *) hb_calloc (length, 1);
+    if (unlikely (!buf))
+      return hb_blob_get_empty ();
+
+    auto *header = (hb_face_snapshot_header_t *) (void *) buf;
+    header->magic = HB_FACE_SNAPSHOT_MAGIC;
+    header->version = HB_FACE_SNAPSHOT_VERSION;
+    header->byte_order = HB_FACE_SNAPSHOT_BYTE_ORDER;
+    header->hb_version = HB_VERSION_MAJOR << 16 | HB_VERSION_MINOR << 8 | HB_VERSION_MICRO;
+    header->digest_size = sizeof (hb_set_digest_t);
+    header->num_glyphs = face->get_num_glyphs ();
+    header->section_count = sections.length;
+
+    auto *out = (hb_face_snapshot_section_t *) (void *) (buf + sizeof (*header));
+    for (unsigned i = 0; i < sections.length; i++)
+    {
+      out[i] = sections.arrayZ[i];
+      out[i].offset += data_offset;
+    }
+    hb_memcpy (buf + data_offset, data.arrayZ, data.length);
+
+    return hb_blob_create (buf, length, HB_MEMORY_MODE_WRITABLE, buf, hb_free);
+  }
+};
+
+hb_blob_t *hb_ot_face_t::serialize_accelerators () const
+{
+  hb_ot_face_snapshot_writer_t c;
+  c.face = face;
+
+#ifndef HB_NO_OT_LAYOUT
+  c.add_lookups (HB_OT_TAG_GSUB, *GSUB);
+  c.add_lookups (HB_OT_TAG_GPOS, *GPOS);
+#endif
+#ifndef HB_NO_OT_FONT_GLYPH_NAMES
+  c.add_glyph_names (HB_OT_TAG_post, post->get_gids_sorted_by_name ());
+#endif
+
+  return c.serialize ();
+}
+
+
+/*
+ * Memory accounting.
+ */
+
+template <typename T> static auto
+_hb_ot_face_memory_usage (const T &accel, hb_priority<2>) HB_AUTO_RETURN
+( accel.get_memory_usage () )
+static unsigned
+_hb_ot_face_memory_usage (const hb_blob_t &blob, hb_priority<1>)
+{
+  /* Table blobs point into the font data, unless the sanitizer had to
+   * make a writable copy to fix the table up. */
+  return sizeof (blob) + (blob.mode == HB_MEMORY_MODE_WRITABLE ? blob.length : 0);
+}
+template <typename T> static unsigned
+_hb_ot_face_memory_usage (const T &accel HB_UNUSED, hb_priority<0>)
+{ return sizeof (T); }
+
+template <typename T> static auto
+_hb_ot_face_trim (const T &accel, hb_priority<1>) HB_AUTO_RETURN
+( accel.trim () )
+template <typename T> static void
+_hb_ot_face_trim (const T &accel HB_UNUSED, hb_priority<0>) {}
+
+void hb_ot_face_t::get_memory_usage (hb_vector_t<hb_pair_t<hb_tag_t, unsigned>> &entries) const
+{
+#define HB_OT_TABLE(Namespace, Type) \
+  { \
+    auto *p = Type.get_stored_if_loaded (); \
+    if (p) \
+      entries.push (hb_pair ((hb_tag_t) Namespace::Type::tableTag, \
+			     (unsigned) _hb_ot_face_memory_usage (*p, hb_prioritize))); \
+  }
+#include "hb-ot-face-table-list.hh"
+#undef HB_OT_TABLE
+}
+
+void hb_ot_face_t::trim () const
+{
+#define HB_OT_TABLE(Namespace, Type) \
+  { \
+    auto *p = Type.get_stored_if_loaded (); \
+    if (p) \
+      _hb_ot_face_trim (*p, hb_prioritize); \
+  }
+#define HB_OT_CORE_TABLE(Namespace, Type) /* Blobs only; nothing to trim. */
+#include "hb-ot-face-table-list.hh"
+#undef HB_OT_CORE_TABLE
+#undef HB_OT_TABLE
+}
@@ -50,6 +50,24 @@ struct hb_ot_face_t
   HB_INTERNAL void init0 (hb_face_t *face);
   HB_INTERNAL void fini ();
 
+  /* Loads the tables of tags, or the default set if tags is nullptr,
+   * and builds their accelerators; see hb_face_warmup(). */
+  HB_INTERNAL void warm_up (const hb_tag_t     *tags,
+			    unsigned int        count,
+			    hb_executor_func_t  executor,
+			    void               *executor_data) const;
+
+  /* Builds and serializes the accelerators that can be saved; see
+   * hb_face_serialize_accelerators(). */
+  HB_INTERNAL hb_blob_t *serialize_accelerators () const;
+
+  /* Appends the tag and heap memory use of each loaded table; see
+   * hb_face_get_memory_usage(). */
+  HB_INTERNAL void get_memory_usage (hb_vector_t<hb_pair_t<hb_tag_t, unsigned>> &entries) const;
+  /* Frees what the loaded accelerators can rebuild on demand; see
+   * hb_face_trim(). */
+  HB_INTERNAL void trim () const;
+
 #define HB_OT_TABLE_ORDER(Namespace, Type) \
     HB_PASTE (ORDER_, HB_PASTE (Namespace, HB_PASTE (_, Type)))
   enum order_t
@@ -33,6 +33,7 @@
 #include "hb-cache.hh"
 #include "hb-font.hh"
 #include "hb-machinery.hh"
+#include "hb-sharded-pool.hh"
 #include "hb-ot-face.hh"
 
 #include "hb-ot-cmap-table.hh"
@@ -61,89 +62,106 @@
  * never need to call these functions directly.
  **/
 
-using hb_ot_font_advance_cache_t = hb_cache_t<24, 16>;
-static_assert (sizeof (hb_ot_font_advance_cache_t) == 1024, "");
+using hb_ot_font_advance_cache_t = hb_sized_cache_t<24, 16>;
+
+/* Default advance-cache size, as log2 of the number of slots, is picked
+ * from the glyph count by hb_glyph_cache_bits(), up to this many bits. */
+#ifndef HB_OT_FONT_ADVANCE_CACHE_MAX_DEFAULT_BITS
+#define HB_OT_FONT_ADVANCE_CACHE_MAX_DEFAULT_BITS 11
+#endif
+
+#ifndef HB_OT_FONT_CACHED_INSTANCES
+#define HB_OT_FONT_CACHED_INSTANCES 4
+#endif
+
+#ifndef HB_OT_FONT_EXTENTS_CACHE_SIZE
+#define HB_OT_FONT_EXTENTS_CACHE_SIZE 256
+#endif
+
+/* Direct-mapped cache of glyph extents, valid for one font serial.
+ * Used by one thread at a time; see hb_ot_font_t::acquire_extents_cache(). */
+struct hb_ot_font_extents_cache_t
+{
+  static_assert (HB_OT_FONT_EXTENTS_CACHE_SIZE &&
+		 !(HB_OT_FONT_EXTENTS_CACHE_SIZE & (HB_OT_FONT_EXTENTS_CACHE_SIZE - 1)), "");
+
+  struct item_t
+  {
+    hb_codepoint_t glyph;
+    hb_glyph_extents_t extents;
+  };
+
+  void reset (unsigned serial_)
+  {
+    serial = serial_;
+    for (auto &item : items)
+      item.glyph = HB_CODEPOINT_INVALID;
+  }
+
+  bool get (hb_codepoint_t glyph, hb_glyph_extents_t *extents) const
+  {
+    const item_t &item = items[glyph & (HB_OT_FONT_EXTENTS_CACHE_SIZE - 1)];
+    if (item.glyph != glyph)
+      return false;
+    *extents = item.extents;
+    return true;
+  }
+
+  void set (hb_codepoint_t glyph, const hb_glyph_extents_t &extents)
+  {
+    item_t &item = items[glyph & (HB_OT_FONT_EXTENTS_CACHE_SIZE - 1)];
+    item.glyph = glyph;
+    item.extents = extents;
+  }
+
+  unsigned serial;
+  item_t items[HB_OT_FONT_EXTENTS_CACHE_SIZE];
+};
 
 struct hb_ot_font_t
 {
   const hb_ot_face_t *ot_face;
 
   /* h_advance caching */
-  mutable hb_atomic_t<int> cached_coords_serial;
   struct advance_cache_t
   {
-    mutable hb_atomic_t<hb_ot_font_advance_cache_t *> advance_cache;
-    mutable hb_atomic_t<OT::ItemVariationStore::cache_t *> varStore_cache;
+    hb_sharded_pool_t<hb_ot_font_advance_cache_t> advance_caches;
+    hb_sharded_pool_t<OT::ItemVariationStore::cache_t> varStore_caches;
 
     ~advance_cache_t ()
     {
       clear ();
     }
 
-    hb_ot_font_advance_cache_t *acquire_advance_cache () const
+    hb_ot_font_advance_cache_t *acquire_advance_cache (unsigned cache_bits) const
     {
-    retry:
-      auto *cache = advance_cache.get_acquire ();
-      if (!cache)
-      {
-        cache = (hb_ot_font_advance_cache_t *) hb_malloc (sizeof (hb_ot_font_advance_cache_t));
-	if (!cache)
-	  return nullptr;
-	new (cache) hb_ot_font_advance_cache_t;
-	return cache;
-      }
-      if (advance_cache.cmpexch (cache, nullptr))
-        return cache;
-      else
-        goto retry;
+      return advance_caches.acquire ([cache_bits] () {
+	return hb_ot_font_advance_cache_t::create (cache_bits);
+      });
     }
     void release_advance_cache (hb_ot_font_advance_cache_t *cache) const
     {
-      if (!cache)
-        return;
-      if (!advance_cache.cmpexch (nullptr, cache))
-        hb_free (cache);
+      advance_caches.release (cache, hb_ot_font_advance_cache_t::destroy);
     }
     void clear_advance_cache () const
     {
-    retry:
-      auto *cache = advance_cache.get_acquire ();
-      if (!cache)
-	return;
-      if (advance_cache.cmpexch (cache, nullptr))
-	hb_free (cache);
-      else
-        goto retry;
+      advance_caches.clear (hb_ot_font_advance_cache_t::destroy);
     }
 
-    OT::ItemVariationStore::cache_t *acquire_varStore_cache (const OT::ItemVariationStore &varStore) const
+    OT::ItemVariationStore::cache_t *acquire_varStore_cache (const OT::ItemVariationStore &varStore,
+							     const hb_font_t *font) const
     {
-    retry:
-      auto *cache = varStore_cache.get_acquire ();
-      if (!cache)
-	return varStore.create_cache ();
-      if (varStore_cache.cmpexch (cache, nullptr))
-	return cache;
-      else
-	goto retry;
+      return varStore_caches.acquire ([&varStore, font] () {
+	return varStore.create_cache (font->coords, font->num_coords);
+      });
     }
     void release_varStore_cache (OT::ItemVariationStore::cache_t *cache) const
     {
-      if (!cache)
-	return;
-      if (!varStore_cache.cmpexch (nullptr, cache))
-	OT::ItemVariationStore::destroy_cache (cache);
+      varStore_caches.release (cache, OT::ItemVariationStore::destroy_cache);
     }
     void clear_varStore_cache () const
     {
-    retry:
-      auto *cache = varStore_cache.get_acquire ();
-      if (!cache)
-	return;
-      if (varStore_cache.cmpexch (cache, nullptr))
-	OT::ItemVariationStore::destroy_cache (cache);
-      else
-	goto retry;
+      varStore_caches.clear (OT::ItemVariationStore::destroy_cache);
     }
 
     void clear () const
@@ -152,20 +170,159 @@ struct hb_ot_font_t
       clear_varStore_cache ();
     }
 
-  } h, v;
+  };
+
+  /* Advances depend on the variation coordinates.  Instead of dropping
+   * the caches whenever the coordinates change, we keep them for a few
+   * recently used instances, such that switching back and forth between
+   * them (eg. when animating, or alternating named instances) finds the
+   * caches warm. */
+  struct instance_t
+  {
+    hb_vector_t<int> coords;
+    bool valid = false;
+    unsigned last_used = 0;
+    advance_cache_t h, v;
+  };
+
+  hb_ot_font_t ()
+  {
+    cached_coords_serial = -1;
+    extents_cheap = -1;
+  }
+  ~hb_ot_font_t ()
+  {
+    extents_caches.clear (hb_free);
+  }
+
+  /* Extents of static glyf glyphs come straight from the glyph header;
+   * anything else (CFF charstrings, gvar deltas, COLR paint graphs,
+   * VARC components) is worth caching. */
+  bool extents_worth_caching (hb_font_t *font) const
+  {
+    if (font->num_coords)
+      return true;
+
+    int cheap = extents_cheap.get_relaxed ();
+    if (unlikely (cheap < 0))
+    {
+      cheap = ot_face->glyf->has_data ()
+#if !defined(HB_NO_COLOR) && !defined(HB_NO_PAINT)
+	   && !ot_face->COLR->has_data ()
+#endif
+#ifndef HB_NO_VAR_COMPOSITES
+	   && !ot_face->VARC->has_data ()
+#endif
+	   ;
+      extents_cheap.set_relaxed (cheap);
+    }
+    return !cheap;
+  }
+
+  hb_ot_font_extents_cache_t *acquire_extents_cache (hb_font_t *font) const
+  {
+    unsigned serial = font->serial.get_acquire ();
+    auto *cache = extents_caches.acquire ([serial] () {
+      auto *cache = (hb_ot_font_extents_cache_t *) hb_malloc (sizeof (hb_ot_font_extents_cache_t));
+      if (likely (cache))
+	cache->reset (serial);
+      return cache;
+    });
+    if (likely (cache) && cache->serial != serial)
+      cache->reset (serial);
+    return cache;
+  }
+  void release_extents_cache (hb_ot_font_extents_cache_t *cache) const
+  {
+    extents_caches.release (cache, hb_free);
+  }
 
-  void check_serial (hb_font_t *font) const
+  static unsigned default_advance_cache_bits (hb_face_t *face)
+  {
+    return hb_glyph_cache_bits (face->get_num_glyphs (),
+				HB_OT_FONT_ADVANCE_CACHE_MAX_DEFAULT_BITS);
+  }
+
+  unsigned get_advance_cache_bits () const { return advance_cache_bits.get_relaxed (); }
+
+  void set_advance_cache_bits (unsigned bits)
+  {
+    bits = hb_ot_font_advance_cache_t::clamp_bits (bits);
+
+    hb_lock_t lock (this->lock);
+    advance_cache_bits.set_relaxed (bits);
+    for (auto &instance : instances)
+    {
+      instance.h.clear_advance_cache ();
+      instance.v.clear_advance_cache ();
+    }
+    advance_cache_hits.set_relaxed (0);
+    advance_cache_misses.set_relaxed (0);
+  }
+
+  /* Counted per call rather than per glyph, to keep them off the hot
+   * path. */
+  void record_advance_cache_stats (unsigned hits, unsigned misses) const
+  {
+    if (hits) advance_cache_hits.add (hits);
+    if (misses) advance_cache_misses.add (misses);
+  }
+  void get_advance_cache_stats (unsigned *hits, unsigned *misses) const
+  {
+    if (hits) *hits = advance_cache_hits.get_relaxed ();
+    if (misses) *misses = advance_cache_misses.get_relaxed ();
+  }
+
+  const instance_t &get_instance (hb_font_t *font) const
   {
     int font_serial = font->serial_coords.get_acquire ();
 
     if (cached_coords_serial.get_acquire () == font_serial)
-      return;
+      return instances[cached_instance.get_relaxed ()];
+
+    hb_lock_t lock (this->lock);
+
+    auto coords = hb_array (font->coords, font->num_coords);
+    unsigned index = 0;
+    for (unsigned i = 0; i < HB_OT_FONT_CACHED_INSTANCES; i++)
+    {
+      if (instances[i].valid && instances[i].coords.as_array () == coords)
+      {
+	index = i;
+	goto done;
+      }
+      if (instances[i].last_used < instances[index].last_used)
+	index = i;
+    }
 
-    h.clear ();
-    v.clear ();
+    {
+      /* Evict the least-recently used instance. */
+      instance_t &instance = instances[index];
+      instance.h.clear ();
+      instance.v.clear ();
+      instance.coords.reset ();
+      instance.coords.extend (coords);
+      instance.valid = !instance.coords.in_error ();
+    }
 
+  done:
+    instances[index].last_used = ++tick;
+    cached_instance.set_relaxed (index);
     cached_coords_serial.set_release (font_serial);
+    return instances[index];
   }
+
+  private:
+  mutable hb_mutex_t lock;
+  mutable hb_atomic_t<int> cached_coords_serial;
+  mutable hb_atomic_t<unsigned> cached_instance;
+  mutable instance_t instances[HB_OT_FONT_CACHED_INSTANCES];
+  mutable unsigned tick = 0;
+  hb_atomic_t<unsigned> advance_cache_bits;
+  mutable hb_atomic_t<unsigned> advance_cache_hits;
+  mutable hb_atomic_t<unsigned> advance_cache_misses;
+  mutable hb_atomic_t<int> extents_cheap;
+  hb_sharded_pool_t<hb_ot_font_extents_cache_t> extents_caches;
 };
 
 static hb_ot_font_t *
@@ -174,8 +331,10 @@ _hb_ot_font_create (hb_font_t *font)
   hb_ot_font_t *ot_font = (hb_ot_font_t *) hb_calloc (1, sizeof (hb_ot_font_t));
   if (unlikely (!ot_font))
     return nullptr;
+  new (ot_font) hb_ot_font_t;
 
   ot_font->ot_face = &font->face->table;
+  ot_font->set_advance_cache_bits (hb_ot_font_t::default_advance_cache_bits (font->face));
 
   return ot_font;
 }
@@ -247,22 +406,23 @@ hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
   const hb_ot_face_t *ot_face = ot_font->ot_face;
   const OT::hmtx_accelerator_t &hmtx = *ot_face->hmtx;
 
-  ot_font->check_serial (font);
+  if (!font->num_coords)
+  {
+    hmtx.get_advances_without_var (count,
+				   first_glyph, glyph_stride,
+				   first_advance, advance_stride,
+				   [font] (unsigned advance) { return font->em_scale_x (advance); });
+    return;
+  }
+
+  const auto &caches = ot_font->get_instance (font).h;
   const OT::HVAR &HVAR = *hmtx.var_table;
   const OT::ItemVariationStore &varStore = &HVAR + HVAR.varStore;
-  OT::ItemVariationStore::cache_t *varStore_cache = ot_font->h.acquire_varStore_cache (varStore);
+  OT::ItemVariationStore::cache_t *varStore_cache = caches.acquire_varStore_cache (varStore, font);
 
-  hb_ot_font_advance_cache_t *advance_cache = nullptr;
+  hb_ot_font_advance_cache_t *advance_cache = caches.acquire_advance_cache (ot_font->get_advance_cache_bits ());
 
-  bool use_cache = font->num_coords;
-  if (use_cache)
-  {
-    advance_cache = ot_font->h.acquire_advance_cache ();
-    if (!advance_cache)
-      use_cache = false;
-  }
-
-  if (!use_cache)
+  if (unlikely (!advance_cache))
   {
     for (unsigned int i = 0; i < count; i++)
     {
@@ -273,6 +433,7 @@ hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
   }
   else
   { /* Use cache. */
+    unsigned misses = 0;
     for (unsigned int i = 0; i < count; i++)
     {
       hb_position_t v;
@@ -283,16 +444,18 @@ hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
       {
         v = hmtx.get_advance_with_var_unscaled (*first_glyph, font, varStore_cache);
 	advance_cache->set (*first_glyph, v);
+	misses++;
       }
       *first_advance = font->em_scale_x (v);
       first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
       first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
     }
 
-    ot_font->h.release_advance_cache (advance_cache);
+    caches.release_advance_cache (advance_cache);
+    ot_font->record_advance_cache_stats (count - misses, misses);
   }
 
-  ot_font->h.release_varStore_cache (varStore_cache);
+  caches.release_varStore_cache (varStore_cache);
 }
 
 #ifndef HB_NO_VERTICAL
@@ -309,12 +472,19 @@ hb_ot_get_glyph_v_advances (hb_font_t* font, void* font_data,
   const hb_ot_face_t *ot_face = ot_font->ot_face;
   const OT::vmtx_accelerator_t &vmtx = *ot_face->vmtx;
 
-  if (vmtx.has_data ())
+  if (vmtx.has_data () && !font->num_coords)
+  {
+    vmtx.get_advances_without_var (count,
+				   first_glyph, glyph_stride,
+				   first_advance, advance_stride,
+				   [font] (unsigned advance) { return font->em_scale_y (-(int) advance); });
+  }
+  else if (vmtx.has_data ())
   {
-    ot_font->check_serial (font);
+    const auto &caches = ot_font->get_instance (font).v;
     const OT::VVAR &VVAR = *vmtx.var_table;
     const OT::ItemVariationStore &varStore = &VVAR + VVAR.varStore;
-    OT::ItemVariationStore::cache_t *varStore_cache = ot_font->v.acquire_varStore_cache (varStore);
+    OT::ItemVariationStore::cache_t *varStore_cache = caches.acquire_varStore_cache (varStore, font);
     // TODO Use advance_cache.
 
     for (unsigned int i = 0; i < count; i++)
@@ -324,7 +494,7 @@ hb_ot_get_glyph_v_advances (hb_font_t* font, void* font_data,
       first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
     }
 
-    ot_font->v.release_varStore_cache (varStore_cache);
+    caches.release_varStore_cache (varStore_cache);
   }
   else
   {
@@ -402,16 +572,12 @@ hb_ot_get_glyph_v_origin (hb_font_t *font,
 }
 #endif
 
-static hb_bool_t
-hb_ot_get_glyph_extents (hb_font_t *font,
-			 void *font_data,
-			 hb_codepoint_t glyph,
-			 hb_glyph_extents_t *extents,
-			 void *user_data HB_UNUSED)
+static bool
+_hb_ot_get_glyph_extents_uncached (hb_font_t *font,
+				   const hb_ot_face_t *ot_face,
+				   hb_codepoint_t glyph,
+				   hb_glyph_extents_t *extents)
 {
-  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
-  const hb_ot_face_t *ot_face = ot_font->ot_face;
-
 #if !defined(HB_NO_OT_FONT_BITMAP) && !defined(HB_NO_COLOR)
   if (ot_face->sbix->get_extents (font, glyph, extents)) return true;
   if (ot_face->CBDT->get_extents (font, glyph, extents)) return true;
@@ -431,6 +597,38 @@ hb_ot_get_glyph_extents (hb_font_t *font,
   return false;
 }
 
+static hb_bool_t
+hb_ot_get_glyph_extents (hb_font_t *font,
+			 void *font_data,
+			 hb_codepoint_t glyph,
+			 hb_glyph_extents_t *extents,
+			 void *user_data HB_UNUSED)
+{
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  const hb_ot_face_t *ot_face = ot_font->ot_face;
+
+#ifndef HB_NO_OT_FONT_EXTENTS_CACHE
+  if (ot_font->extents_worth_caching (font))
+  {
+    hb_ot_font_extents_cache_t *cache = ot_font->acquire_extents_cache (font);
+    if (likely (cache))
+    {
+      bool ret = cache->get (glyph, extents);
+      if (!ret)
+      {
+	ret = _hb_ot_get_glyph_extents_uncached (font, ot_face, glyph, extents);
+	if (ret)
+	  cache->set (glyph, *extents);
+      }
+      ot_font->release_extents_cache (cache);
+      return ret;
+    }
+  }
+#endif
+
+  return _hb_ot_get_glyph_extents_uncached (font, ot_face, glyph, extents);
+}
+
 #ifndef HB_NO_OT_FONT_GLYPH_NAMES
 static hb_bool_t
 hb_ot_get_glyph_name (hb_font_t *font HB_UNUSED,
@@ -616,4 +814,84 @@ hb_ot_font_set_funcs (hb_font_t *font)
 		     _hb_ot_font_destroy);
 }
 
+static hb_ot_font_t *
+_hb_ot_font_get (hb_font_t *font)
+{
+  if (font->klass != _hb_ot_get_font_funcs ())
+    return nullptr;
+  return (hb_ot_font_t *) font->user_data;
+}
+
+/**
+ * hb_ot_font_set_advance_cache_size:
+ * @font: #hb_font_t to work upon
+ * @size: number of glyph advances to cache, or zero for the default
+ *
+ * Sets the number of glyph advances that the HarfBuzz native font
+ * functions on @font cache, per variation instance, when @font is
+ * variable.  The default is picked from the number of glyphs in the
+ * font, and is adequate for most fonts; fonts with very large glyph
+ * repertoires in use at once, as common with CJK text, may benefit from
+ * a larger cache.  The cache hit rate can be monitored using
+ * hb_ot_font_get_advance_cache_stats().
+ *
+ * @size is rounded up to a power of two, and clamped to the supported
+ * range.  Setting the size discards all cached advances and resets the
+ * statistics.
+ *
+ * This function does nothing if @font is not using the functions set
+ * by hb_ot_font_set_funcs().  It is not safe to call it while @font is
+ * in use in other threads.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_ot_font_set_advance_cache_size (hb_font_t    *font,
+				   unsigned int  size)
+{
+  hb_ot_font_t *ot_font = _hb_ot_font_get (font);
+  if (!ot_font)
+    return;
+
+  unsigned bits = size ? hb_bit_storage (size - 1)
+		       : hb_ot_font_t::default_advance_cache_bits (font->face);
+  ot_font->set_advance_cache_bits (bits);
+}
+
+/**
+ * hb_ot_font_get_advance_cache_stats:
+ * @font: #hb_font_t to work upon
+ * @size: (out) (optional): number of glyph advances cached per instance
+ * @hits: (out) (optional): number of advances served from the cache
+ * @misses: (out) (optional): number of advances computed and added to the cache
+ *
+ * Fetches the size and usage statistics of the glyph-advance cache of
+ * the HarfBuzz native font functions on @font.  The cache is only used
+ * for variable fonts with variations set; a hit rate that stays low
+ * suggests enlarging the cache using hb_ot_font_set_advance_cache_size().
+ *
+ * All values are zero if @font is not using the functions set by
+ * hb_ot_font_set_funcs().
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_ot_font_get_advance_cache_stats (hb_font_t    *font,
+				    unsigned int *size,
+				    unsigned int *hits,
+				    unsigned int *misses)
+{
+  hb_ot_font_t *ot_font = _hb_ot_font_get (font);
+  if (!ot_font)
+  {
+    if (size) *size = 0;
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    return;
+  }
+
+  if (size) *size = 1u << ot_font->get_advance_cache_bits ();
+  ot_font->get_advance_cache_stats (hits, misses);
+}
+
 #endif
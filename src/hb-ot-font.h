@@ -39,6 +39,16 @@ HB_BEGIN_DECLS
 HB_EXTERN void
 hb_ot_font_set_funcs (hb_font_t *font);
 
+HB_EXTERN void
+hb_ot_font_set_advance_cache_size (hb_font_t    *font,
+				   unsigned int  size);
+
+HB_EXTERN void
+hb_ot_font_get_advance_cache_stats (hb_font_t    *font,
+				    unsigned int *size,
+				    unsigned int *hits,
+				    unsigned int *misses);
+
 
 HB_END_DECLS
 
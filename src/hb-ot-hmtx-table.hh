@@ -402,6 +402,34 @@ struct hmtxvmtx
       return advances[hb_min (glyph - num_bearings, num_advances - num_bearings - 1)];
     }
 
+    /* Batch version of get_advance_without_var_unscaled(), storing
+     * scale (advance) for each glyph.  Glyphs with a long or short
+     * metric, ie. virtually all, take a tight loop of a compare, a
+     * load, and the scale. */
+    template <typename Scale>
+    void get_advances_without_var (unsigned count,
+				   const hb_codepoint_t *first_glyph,
+				   unsigned glyph_stride,
+				   hb_position_t *first_advance,
+				   unsigned advance_stride,
+				   Scale scale) const
+    {
+      const LongMetric *long_metrics = table->longMetricZ.arrayZ;
+      unsigned limit = num_bearings; /* Zero if num_long_metrics is zero. */
+      unsigned last = num_long_metrics - 1;
+
+      for (unsigned i = 0; i < count; i++)
+      {
+	hb_codepoint_t glyph = *first_glyph;
+	unsigned advance = likely (glyph < limit)
+			 ? (unsigned) long_metrics[hb_min (glyph, last)].advance
+			 : get_advance_without_var_unscaled (glyph);
+	*first_advance = scale (advance);
+	first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+	first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+      }
+    }
+
     unsigned get_advance_with_var_unscaled (hb_codepoint_t  glyph,
 					    hb_font_t      *font,
 					    ItemVariationStore::cache_t *store_cache = nullptr) const
@@ -2834,6 +2834,40 @@ struct VarData
    return delta;
   }
 
+  /* Same as above, with the scalars of this subtable's regions evaluated
+   * up front, in regionIndices order.  The delta is then a plain dot
+   * product of the delta row with the scalars. */
+  float get_delta (unsigned int inner,
+		   const float *scalars) const
+  {
+    if (unlikely (inner >= itemCount))
+      return 0.;
+
+   unsigned int count = regionIndices.len;
+   bool is_long = longWords ();
+   unsigned word_count = wordCount ();
+   unsigned int scount = is_long ? count : word_count;
+   unsigned int lcount = is_long ? word_count : 0;
+
+   const HBUINT8 *bytes = get_delta_bytes ();
+   const HBUINT8 *row = bytes + inner * get_row_size ();
+
+   float delta = 0.;
+   unsigned int i = 0;
+
+   const HBINT32 *lcursor = reinterpret_cast<const HBINT32 *> (row);
+   for (; i < lcount; i++)
+     delta += scalars[i] * *lcursor++;
+   const HBINT16 *scursor = reinterpret_cast<const HBINT16 *> (lcursor);
+   for (; i < scount; i++)
+     delta += scalars[i] * *scursor++;
+   const HBINT8 *bcursor = reinterpret_cast<const HBINT8 *> (scursor);
+   for (; i < count; i++)
+     delta += scalars[i] * *bcursor++;
+
+   return delta;
+  }
+
   void get_region_scalars (const int *coords, unsigned int coord_count,
 			   const VarRegionList &regions,
 			   float *scalars /*OUT */,
@@ -3187,31 +3221,131 @@ struct MultiVarData
 struct ItemVariationStore
 {
   friend struct item_variations_t;
-  using cache_t = VarRegionList::cache_t;
 
-  cache_t *create_cache () const
+  /* Region scalars of all subtables at one set of coordinates, evaluated
+   * once; every delta fetched through it is then a dot product.  A cache
+   * is only valid for the coordinates it was created with. */
+  struct cache_t
+  {
+    hb_vector_t<unsigned> starts; /* Into scalars, per subtable. */
+    hb_vector_t<float> scalars; /* Per subtable, in its regionIndices order. */
+
+    /* With bake_deltas, the delta of every item, per subtable. */
+    hb_vector_t<unsigned> delta_starts; /* One more than subtables. */
+    hb_vector_t<float> deltas;
+  };
+
+  /* With bake_deltas, also evaluates the delta of every item up front,
+   * such that fetching one is a table lookup.  Meant for fonts that stay
+   * at one instance for long; see hb_font_freeze_instance(). */
+  cache_t *create_cache (const int *coords, unsigned int coord_count,
+			 bool bake_deltas = false) const
   {
 #ifdef HB_NO_VAR
     return nullptr;
 #endif
-    unsigned count = (this+regions).regionCount;
-    if (!count) return nullptr;
+    const VarRegionList &r = this+regions;
+    unsigned region_count = r.regionCount;
+    if (!region_count) return nullptr;
+
+    unsigned count = dataSets.len;
+    unsigned total = 0;
+    for (unsigned i = 0; i < count; i++)
+    {
+      total += (this+dataSets[i]).get_region_index_count ();
+      if (unlikely (total > HB_VAR_STORE_MAX_CACHED_SCALARS))
+	return nullptr;
+    }
+
+    hb_vector_t<float> region_scalars;
+    if (unlikely (!region_scalars.resize_exact (region_count, false)))
+      return nullptr;
+    /* Scalars are never negative; evaluate only the regions in use. */
+    for (unsigned i = 0; i < region_count; i++)
+      region_scalars.arrayZ[i] = -1.f;
 
-    cache_t *cache = (cache_t *) hb_malloc (sizeof (float) * count);
+    cache_t *cache = (cache_t *) hb_calloc (1, sizeof (cache_t));
     if (unlikely (!cache)) return nullptr;
+    new (cache) cache_t ();
+
+    if (unlikely (!cache->starts.resize_exact (count, false) ||
+		  !cache->scalars.resize_exact (total, false)))
+    {
+      destroy_cache (cache);
+      return nullptr;
+    }
 
+    float *p = cache->scalars.arrayZ;
     for (unsigned i = 0; i < count; i++)
-      cache[i] = REGION_CACHE_ITEM_CACHE_INVALID;
+    {
+      const VarData &data = this+dataSets[i];
+      cache->starts.arrayZ[i] = p - cache->scalars.arrayZ;
+      unsigned n = data.get_region_index_count ();
+      for (unsigned j = 0; j < n; j++)
+      {
+	unsigned region = data.get_region_index (j);
+	float v = 0.f;
+	if (likely (region < region_count))
+	{
+	  v = region_scalars.arrayZ[region];
+	  if (v < 0.f)
+	    v = region_scalars.arrayZ[region] = r.evaluate (region, coords, coord_count);
+	}
+	*p++ = v;
+      }
+    }
+
+    if (bake_deltas)
+      cache_deltas (cache);
 
     return cache;
   }
 
-  static void destroy_cache (cache_t *cache) { hb_free (cache); }
+  private:
+  void cache_deltas (cache_t *cache) const
+  {
+    unsigned count = dataSets.len;
+    unsigned total = 0;
+    for (unsigned i = 0; i < count; i++)
+    {
+      total += (this+dataSets[i]).get_item_count ();
+      if (unlikely (total > HB_VAR_STORE_MAX_CACHED_SCALARS))
+	return;
+    }
+
+    if (unlikely (!cache->delta_starts.resize_exact (count + 1, false) ||
+		  !cache->deltas.resize_exact (total, false)))
+    {
+      cache->delta_starts.reset ();
+      cache->deltas.reset ();
+      return;
+    }
+
+    float *p = cache->deltas.arrayZ;
+    for (unsigned i = 0; i < count; i++)
+    {
+      const VarData &data = this+dataSets[i];
+      const float *scalars = cache->scalars.arrayZ + cache->starts.arrayZ[i];
+      cache->delta_starts.arrayZ[i] = p - cache->deltas.arrayZ;
+      unsigned n = data.get_item_count ();
+      for (unsigned j = 0; j < n; j++)
+	*p++ = data.get_delta (j, scalars);
+    }
+    cache->delta_starts.arrayZ[count] = p - cache->deltas.arrayZ;
+  }
+  public:
+
+  static void destroy_cache (cache_t *cache)
+  {
+    if (!cache) return;
+    cache->~cache_t ();
+    hb_free (cache);
+  }
 
   private:
   float get_delta (unsigned int outer, unsigned int inner,
 		   const int *coords, unsigned int coord_count,
-		   VarRegionList::cache_t *cache = nullptr) const
+		   cache_t *cache = nullptr) const
   {
 #ifdef HB_NO_VAR
     return 0.f;
@@ -3220,16 +3354,27 @@ struct ItemVariationStore
     if (unlikely (outer >= dataSets.len))
       return 0.f;
 
+    if (cache)
+    {
+      if (cache->deltas)
+      {
+	unsigned start = cache->delta_starts.arrayZ[outer];
+	unsigned end = cache->delta_starts.arrayZ[outer + 1];
+	return likely (inner < end - start) ? cache->deltas.arrayZ[start + inner] : 0.f;
+      }
+      return (this+dataSets[outer]).get_delta (inner,
+					       cache->scalars.arrayZ + cache->starts.arrayZ[outer]);
+    }
+
     return (this+dataSets[outer]).get_delta (inner,
 					     coords, coord_count,
-					     this+regions,
-					     cache);
+					     this+regions);
   }
 
   public:
   float get_delta (unsigned int index,
 		   const int *coords, unsigned int coord_count,
-		   VarRegionList::cache_t *cache = nullptr) const
+		   cache_t *cache = nullptr) const
   {
     unsigned int outer = index >> 16;
     unsigned int inner = index & 0xFFFF;
@@ -3237,7 +3382,7 @@ struct ItemVariationStore
   }
   float get_delta (unsigned int index,
 		   hb_array_t<const int> coords,
-		   VarRegionList::cache_t *cache = nullptr) const
+		   cache_t *cache = nullptr) const
   {
     return get_delta (index,
 		      coords.arrayZ, coords.length,
@@ -3736,7 +3881,7 @@ struct ItemVarStoreInstancer
   ItemVarStoreInstancer (const ItemVariationStore *varStore_,
 			 const DeltaSetIndexMap *varIdxMap,
 			 hb_array_t<const int> coords,
-			 VarRegionList::cache_t *cache = nullptr) :
+			 ItemVariationStore::cache_t *cache = nullptr) :
     varStore (varStore_), varIdxMap (varIdxMap), coords (coords), cache (cache)
   {
     if (!varStore)
@@ -3762,7 +3907,7 @@ struct ItemVarStoreInstancer
   const ItemVariationStore *varStore;
   const DeltaSetIndexMap *varIdxMap;
   hb_array_t<const int> coords;
-  VarRegionList::cache_t *cache;
+  ItemVariationStore::cache_t *cache;
 };
 
 struct MultiItemVarStoreInstancer
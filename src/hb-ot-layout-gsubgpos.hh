@@ -36,6 +36,7 @@
 #include "hb-ot-map.hh"
 #include "hb-ot-layout-common.hh"
 #include "hb-ot-layout-gdef-table.hh"
+#include "hb-face-snapshot.hh"
 
 
 namespace OT {
@@ -898,6 +899,150 @@ enum class hb_ot_lookup_cache_op_t
   DESTROY,
 };
 
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+
+#ifndef HB_OT_LAYOUT_COVERAGE_BITMAP_MAX_BYTES
+#define HB_OT_LAYOUT_COVERAGE_BITMAP_MAX_BYTES 8192 /* Spans 65536 glyphs. */
+#endif
+#ifndef HB_OT_LAYOUT_COVERAGE_BITMAP_BUDGET
+#define HB_OT_LAYOUT_COVERAGE_BITMAP_BUDGET (256 * 1024) /* Per GSUB / GPOS table. */
+#endif
+
+/* An exact bitmap of the glyphs a subtable covers, between the first and
+ * last covered glyph.
+ *
+ * The set-digest rejects most glyphs a subtable does not cover, but the
+ * ones it lets through pay for a full Coverage lookup (a binary search)
+ * before being rejected.  The bitmap rejects those too, with no further
+ * lookup.  Bitmaps are only built if they are small, and all bitmaps of
+ * a GSUB or GPOS table share a memory budget. */
+struct hb_coverage_bitmap_t
+{
+  template <typename Coverage>
+  void build (const Coverage &coverage, hb_atomic_t<int> *memory)
+  {
+    bounds_t bounds;
+    if (!coverage.collect_coverage (&bounds) || bounds.first > bounds.last)
+      return;
+
+    unsigned length = bounds.last - bounds.first + 1;
+    unsigned size = (length + 63) / 64 * sizeof (uint64_t);
+    if (size > HB_OT_LAYOUT_COVERAGE_BITMAP_MAX_BYTES)
+      return;
+    if (memory->add ((int) size) + size > HB_OT_LAYOUT_COVERAGE_BITMAP_BUDGET)
+    {
+      memory->add (-(int) size);
+      return;
+    }
+
+    uint64_t *bits = (uint64_t *) hb_calloc (1, size);
+    if (unlikely (!bits))
+    {
+      memory->add (-(int) size);
+      return;
+    }
+
+    filler_t filler = {bits, bounds.first};
+    coverage.collect_coverage (&filler);
+
+    this->bits = bits;
+    this->first = bounds.first;
+    this->length = length;
+  }
+
+  /* Uses the bitmap stored in a snapshot section, without copying. */
+  void attach (const hb_face_snapshot_subtable_t &snap, const char *section)
+  {
+    if (!snap.bitmap_length) return;
+    this->bits = (const uint64_t *) (const void *) (section + snap.bitmap_offset);
+    this->first = snap.bitmap_first;
+    this->length = snap.bitmap_length;
+    this->borrowed = true;
+  }
+
+  void fini ()
+  {
+    if (!borrowed)
+      hb_free ((void *) bits);
+    bits = nullptr;
+  }
+
+  /* Heap memory used; borrowed bitmaps are not counted. */
+  unsigned get_size () const
+  { return bits && !borrowed ? get_bitmap_size () : 0; }
+  unsigned get_bitmap_size () const
+  { return bits ? (length + 63) / 64 * sizeof (uint64_t) : 0; }
+
+  void snapshot (hb_face_snapshot_subtable_t *snap) const
+  {
+    snap->bitmap_first = bits ? first : 0;
+    snap->bitmap_length = bits ? length : 0;
+  }
+  hb_array_t<const uint64_t> get_bits () const
+  { return hb_array (bits, get_bitmap_size () / sizeof (uint64_t)); }
+
+  /* Returns true if there is no bitmap. */
+  bool may_have (hb_codepoint_t g) const
+  {
+    if (!bits) return true;
+    unsigned i = g - first;
+    return i < length && ((bits[i / 64] >> (i % 64)) & 1);
+  }
+
+  private:
+
+  struct bounds_t
+  {
+    template <typename A>
+    bool add_sorted_array (const A &arr)
+    {
+      for (hb_codepoint_t g : arr)
+	if (unlikely (!add_range (g, g)))
+	  return false;
+      return true;
+    }
+    bool add_range (hb_codepoint_t a, hb_codepoint_t b)
+    {
+      if (unlikely (a > b)) return false;
+      first = hb_min (first, a);
+      last = hb_max (last, b);
+      return true;
+    }
+
+    hb_codepoint_t first = HB_SET_VALUE_INVALID;
+    hb_codepoint_t last = 0;
+  };
+
+  struct filler_t
+  {
+    template <typename A>
+    bool add_sorted_array (const A &arr)
+    {
+      for (hb_codepoint_t g : arr)
+	add_range (g, g);
+      return true;
+    }
+    bool add_range (hb_codepoint_t a, hb_codepoint_t b)
+    {
+      for (hb_codepoint_t g = a; g <= b; g++)
+      {
+	unsigned i = g - first;
+	bits[i / 64] |= (uint64_t) 1 << (i % 64);
+      }
+      return true;
+    }
+
+    uint64_t *bits;
+    hb_codepoint_t first;
+  };
+
+  const uint64_t *bits;
+  hb_codepoint_t first;
+  unsigned length;
+  bool borrowed;
+};
+#endif
+
 struct hb_accelerate_subtables_context_t :
        hb_dispatch_context_t<hb_accelerate_subtables_context_t>
 {
@@ -951,6 +1096,7 @@ struct hb_accelerate_subtables_context_t :
 	       , hb_apply_func_t apply_cached_func_
 	       , hb_cache_func_t cache_func_
 #endif
+	       , const hb_face_snapshot_subtable_t *snap
 		)
     {
       obj = &obj_;
@@ -959,18 +1105,32 @@ struct hb_accelerate_subtables_context_t :
       apply_cached_func = apply_cached_func_;
       cache_func = cache_func_;
 #endif
-      digest.init ();
-      obj_.get_coverage ().collect_coverage (&digest);
+      if (snap)
+	digest = snap->digest;
+      else
+      {
+	digest.init ();
+	obj_.get_coverage ().collect_coverage (&digest);
+      }
+    }
+
+    bool may_have (hb_codepoint_t g) const
+    {
+      return digest.may_have (g)
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+	  && coverage_bitmap.may_have (g)
+#endif
+	  ;
     }
 
     bool apply (hb_ot_apply_context_t *c) const
     {
-      return digest.may_have (c->buffer->cur().codepoint) && apply_func (obj, c);
+      return may_have (c->buffer->cur().codepoint) && apply_func (obj, c);
     }
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
     bool apply_cached (hb_ot_apply_context_t *c) const
     {
-      return digest.may_have (c->buffer->cur().codepoint) &&  apply_cached_func (obj, c);
+      return may_have (c->buffer->cur().codepoint) &&  apply_cached_func (obj, c);
     }
     bool cache_enter (hb_ot_apply_context_t *c) const
     {
@@ -990,6 +1150,9 @@ struct hb_accelerate_subtables_context_t :
     hb_cache_func_t cache_func;
 #endif
     hb_set_digest_t digest;
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+    hb_coverage_bitmap_t coverage_bitmap;
+#endif
   };
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -1004,6 +1167,7 @@ struct hb_accelerate_subtables_context_t :
   return_t dispatch (const T &obj)
   {
     hb_applicable_t *entry = &array[i++];
+    const hb_face_snapshot_subtable_t *snap = snapshot ? &snapshot[i - 1] : nullptr;
 
     entry->init (obj,
 		 apply_to<T>
@@ -1011,8 +1175,16 @@ struct hb_accelerate_subtables_context_t :
 		 , apply_cached_to<T>
 		 , cache_func_to<T>
 #endif
+		 , snap
 		 );
 
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+    if (snap)
+      entry->coverage_bitmap.attach (*snap, snapshot_section);
+    else if (coverage_bitmap_memory)
+      entry->coverage_bitmap.build (obj.get_coverage (), coverage_bitmap_memory);
+#endif
+
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
     /* Cache handling
      *
@@ -1034,10 +1206,20 @@ struct hb_accelerate_subtables_context_t :
   }
   static return_t default_return_value () { return hb_empty_t (); }
 
-  hb_accelerate_subtables_context_t (hb_applicable_t *array_) :
-				     array (array_) {}
+  hb_accelerate_subtables_context_t (hb_applicable_t *array_,
+				     hb_atomic_t<int> *coverage_bitmap_memory_ = nullptr,
+				     const hb_face_snapshot_subtable_t *snapshot_ = nullptr,
+				     const char *snapshot_section_ = nullptr) :
+				     array (array_),
+				     coverage_bitmap_memory (coverage_bitmap_memory_),
+				     snapshot (snapshot_),
+				     snapshot_section (snapshot_section_) {}
 
   hb_applicable_t *array;
+  hb_atomic_t<int> *coverage_bitmap_memory;
+  /* If not null, digests and bitmaps are taken from here instead. */
+  const hb_face_snapshot_subtable_t *snapshot;
+  const char *snapshot_section;
   unsigned i = 0;
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -4403,8 +4585,15 @@ struct Extension
 
 struct hb_ot_layout_lookup_accelerator_t
 {
+  /* If coverage_bitmap_memory is not null, coverage bitmaps are built
+   * for subtables, within the budget; their size is added to it.
+   * If snapshot is not null, it holds the digests and bitmaps of all
+   * the subtables, already built. */
   template <typename TLookup>
-  static hb_ot_layout_lookup_accelerator_t *create (const TLookup &lookup)
+  static hb_ot_layout_lookup_accelerator_t *create (const TLookup &lookup,
+						    hb_atomic_t<int> *coverage_bitmap_memory = nullptr,
+						    const hb_face_snapshot_subtable_t *snapshot = nullptr,
+						    const char *snapshot_section = nullptr)
   {
     unsigned count = lookup.get_subtable_count ();
 
@@ -4421,7 +4610,12 @@ struct hb_ot_layout_lookup_accelerator_t
     if (unlikely (!thiz))
       return nullptr;
 
-    hb_accelerate_subtables_context_t c_accelerate_subtables (thiz->subtables);
+    thiz->subtable_count = count;
+
+    hb_accelerate_subtables_context_t c_accelerate_subtables (thiz->subtables,
+							       coverage_bitmap_memory,
+							       snapshot,
+							       snapshot_section);
     lookup.dispatch (&c_accelerate_subtables);
 
     thiz->digest.init ();
@@ -4436,7 +4630,9 @@ struct hb_ot_layout_lookup_accelerator_t
 
     if (thiz->cache_user_idx != (unsigned) -1)
     {
-      thiz->cache = thiz->subtables[thiz->cache_user_idx].cache_func (nullptr, hb_ot_lookup_cache_op_t::CREATE);
+      /* For CREATE, the cache function gets the subtable. */
+      const auto &subtable = thiz->subtables[thiz->cache_user_idx];
+      thiz->cache = subtable.cache_func ((void *) subtable.obj, hb_ot_lookup_cache_op_t::CREATE);
       if (!thiz->cache)
 	thiz->cache_user_idx = (unsigned) -1;
     }
@@ -4457,12 +4653,51 @@ struct hb_ot_layout_lookup_accelerator_t
       assert (cache_user_idx != (unsigned) -1);
       subtables[cache_user_idx].cache_func (cache, hb_ot_lookup_cache_op_t::DESTROY);
     }
+#endif
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+    for (unsigned i = 0; i < subtable_count; i++)
+      subtables[i].coverage_bitmap.fini ();
 #endif
   }
 
+  /* Heap memory used, except for the lookup cache. */
+  unsigned get_memory_usage () const
+  {
+    return sizeof (hb_ot_layout_lookup_accelerator_t) -
+	   HB_VAR_ARRAY * sizeof (hb_accelerate_subtables_context_t::hb_applicable_t) +
+	   subtable_count * sizeof (hb_accelerate_subtables_context_t::hb_applicable_t) +
+	   get_coverage_bitmap_size ();
+  }
+
+  unsigned get_coverage_bitmap_size () const
+  {
+    unsigned size = 0;
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+    for (unsigned i = 0; i < subtable_count; i++)
+      size += subtables[i].coverage_bitmap.get_size ();
+#endif
+    return size;
+  }
+
   bool may_have (hb_codepoint_t g) const
   { return digest.may_have (g); }
 
+  unsigned get_subtable_count () const { return subtable_count; }
+
+  /* Fills in snap and returns the coverage bitmap of subtable i. */
+  hb_array_t<const uint64_t> snapshot (unsigned i, hb_face_snapshot_subtable_t *snap) const
+  {
+    const auto &subtable = subtables[i];
+    snap->digest = subtable.digest;
+    snap->bitmap_first = snap->bitmap_length = snap->bitmap_offset = snap->reserved = 0;
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+    subtable.coverage_bitmap.snapshot (snap);
+    return subtable.coverage_bitmap.get_bits ();
+#else
+    return hb_array_t<const uint64_t> ();
+#endif
+  }
+
 #ifndef HB_OPTIMIZE_SIZE
   HB_ALWAYS_INLINE
 #endif
@@ -4515,6 +4750,7 @@ struct hb_ot_layout_lookup_accelerator_t
   unsigned cache_user_idx = (unsigned) -1;
 #endif
   private:
+  unsigned subtable_count;
   hb_accelerate_subtables_context_t::hb_applicable_t subtables[HB_VAR_ARRAY];
 };
 
@@ -4895,6 +5131,13 @@ struct GSUBGPOS
 	this->table.destroy ();
 	this->table = hb_blob_get_empty ();
       }
+
+      /* Validated by hb_face_attach_accelerators(), except for the lookup
+       * count, which a blocklisted table changes. */
+      unsigned snapshot_length;
+      auto *snapshot = (const hb_face_snapshot_lookups_t *) face->get_snapshot_section (T::tableTag, &snapshot_length);
+      if (snapshot && snapshot->lookup_count == this->lookup_count)
+	this->snapshot = snapshot;
     }
     ~accelerator_t ()
     {
@@ -4919,12 +5162,32 @@ struct GSUBGPOS
       auto *accel = accels[lookup_index].get_acquire ();
       if (unlikely (!accel))
       {
-	accel = hb_ot_layout_lookup_accelerator_t::create (table->get_lookup (lookup_index));
+	const auto &lookup = table->get_lookup (lookup_index);
+	const hb_face_snapshot_subtable_t *snap = nullptr;
+	if (snapshot)
+	{
+	  unsigned start = snapshot->first_subtable[lookup_index];
+	  unsigned end = snapshot->first_subtable[lookup_index + 1];
+	  if (end - start == lookup.get_subtable_count ())
+	    snap = get_snapshot_subtables () + start;
+	}
+
+	accel = hb_ot_layout_lookup_accelerator_t::create (lookup,
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+							   &coverage_bitmap_memory,
+#else
+							   nullptr,
+#endif
+							   snap,
+							   (const char *) snapshot);
 	if (unlikely (!accel))
 	  return nullptr;
 
 	if (unlikely (!accels[lookup_index].cmpexch (nullptr, accel)))
 	{
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+	  coverage_bitmap_memory.add (-(int) accel->get_coverage_bitmap_size ());
+#endif
 	  accel->fini ();
 	  hb_free (accel);
 	  goto retry;
@@ -4934,9 +5197,61 @@ struct GSUBGPOS
       return accel;
     }
 
+    unsigned get_memory_usage () const
+    {
+      unsigned size = sizeof (*this) + lookup_count * sizeof (accels[0]);
+      for (unsigned i = 0; i < lookup_count; i++)
+      {
+	auto *accel = accels[i].get_acquire ();
+	if (accel)
+	  size += accel->get_memory_usage ();
+      }
+      return size;
+    }
+
+    /* Frees the lookup accelerators, to be rebuilt on next use.  Must
+     * not run concurrently with any other use of the face. */
+    void trim () const
+    {
+      for (unsigned i = 0; i < lookup_count; i++)
+      {
+	auto *accel = accels[i].get_relaxed ();
+	if (!accel)
+	  continue;
+	accels[i].set_relaxed (nullptr);
+	accel->fini ();
+	hb_free (accel);
+      }
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+      coverage_bitmap_memory.set_relaxed (0);
+#endif
+    }
+
+    /* Bytes used by coverage bitmaps of all lookups created so far. */
+    unsigned get_coverage_bitmap_memory () const
+    {
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+      return coverage_bitmap_memory.get_relaxed ();
+#else
+      return 0;
+#endif
+    }
+
     hb_blob_ptr_t<T> table;
     unsigned int lookup_count;
     hb_atomic_t<hb_ot_layout_lookup_accelerator_t *> *accels;
+#ifndef HB_NO_OT_LAYOUT_COVERAGE_BITMAP
+    mutable hb_atomic_t<int> coverage_bitmap_memory;
+#endif
+    /* Attached with hb_face_attach_accelerators(), if any. */
+    const hb_face_snapshot_lookups_t *snapshot = nullptr;
+
+    private:
+    const hb_face_snapshot_subtable_t *get_snapshot_subtables () const
+    {
+      return (const hb_face_snapshot_subtable_t *)
+	     ((const char *) snapshot + hb_face_snapshot_lookups_t::get_subtables_offset (snapshot->lookup_count));
+    }
   };
 
   protected:
@@ -398,6 +398,23 @@ hb_ot_layout_get_ligature_carets (hb_font_t      *font,
 				  unsigned int   *caret_count /* IN/OUT */,
 				  hb_position_t  *caret_array /* OUT */)
 {
+  if (const hb_frozen_instance_t *frozen = font->get_frozen_instance ())
+  {
+    const hb_vector_t<hb_position_t> *carets = frozen->get_ligature_carets (HB_DIRECTION_IS_VERTICAL (direction), glyph);
+    if (!carets)
+    {
+      if (caret_count) *caret_count = 0;
+      return 0;
+    }
+    if (caret_count)
+    {
+      + carets->as_array ().sub_array (start_offset, caret_count)
+      | hb_sink (hb_array (caret_array, *caret_count))
+      ;
+    }
+    return carets->length;
+  }
+
   return font->face->table.GDEF->table->get_lig_carets (font, direction, glyph, start_offset, caret_count, caret_array);
 }
 #endif
@@ -1084,6 +1101,34 @@ hb_ot_layout_table_get_lookup_count (hb_face_t    *face,
   return get_gsubgpos_table (face, table_tag).get_lookup_count ();
 }
 
+/**
+ * hb_ot_layout_table_get_coverage_bitmap_memory:
+ * @face: #hb_face_t to work upon
+ * @table_tag: #HB_OT_TAG_GSUB or #HB_OT_TAG_GPOS
+ *
+ * Fetches the number of bytes used by the coverage bitmaps of the
+ * specified face's GSUB table or GPOS table.
+ *
+ * To speed up shaping, HarfBuzz keeps an exact bitmap of the glyphs
+ * covered by each subtable of a lookup, for subtables whose coverage
+ * spans a moderate range of glyph ids.  Bitmaps are built when a lookup
+ * is first used, and their total size for each table is bounded.
+ *
+ * Return value: Memory used by coverage bitmaps, in bytes.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_ot_layout_table_get_coverage_bitmap_memory (hb_face_t    *face,
+					       hb_tag_t      table_tag)
+{
+  switch (table_tag) {
+    case HB_OT_TAG_GSUB: return face->table.GSUB->get_coverage_bitmap_memory ();
+    case HB_OT_TAG_GPOS: return face->table.GPOS->get_coverage_bitmap_memory ();
+    default:             return 0;
+  }
+}
+
 
 struct hb_collect_features_context_t
 {
@@ -1913,6 +1958,39 @@ struct GPOSProxy
 };
 
 
+/* Returns the position of the first glyph in [start, end) that passes
+ * the lookup digest and mask, or end if there is none.
+ *
+ * Lookups typically only touch a few glyphs of a long run.  Testing the
+ * glyphs in blocks, without branching on each one, lets the compiler
+ * schedule (and, where the target allows, vectorize) the digest checks,
+ * and lets apply_forward() skip uncovered glyphs in one go. */
+static inline unsigned
+find_next_candidate (const hb_set_digest_t &digest,
+		     hb_mask_t lookup_mask,
+		     const hb_glyph_info_t *info,
+		     unsigned start,
+		     unsigned end)
+{
+  static constexpr unsigned BLOCK = 8;
+
+  unsigned i = start;
+  for (; i + BLOCK <= end; i += BLOCK)
+  {
+    unsigned bits = 0;
+    for (unsigned j = 0; j < BLOCK; j++)
+      bits |= (unsigned) (digest.may_have_branchless (info[i + j].codepoint) &
+			  !!(info[i + j].mask & lookup_mask)) << j;
+    if (bits)
+      return i + hb_ctz (bits);
+  }
+  for (; i < end; i++)
+    if (digest.may_have (info[i].codepoint) &&
+	(info[i].mask & lookup_mask))
+      break;
+  return i;
+}
+
 static inline bool
 apply_forward (OT::hb_ot_apply_context_t *c,
 	       const OT::hb_ot_layout_lookup_accelerator_t &accel,
@@ -1926,12 +2004,18 @@ apply_forward (OT::hb_ot_apply_context_t *c,
   {
     bool applied = false;
     auto &cur = buffer->cur();
-    if (accel.digest.may_have (cur.codepoint) &&
-	(cur.mask & c->lookup_mask) &&
-	c->check_glyph_property (&cur, c->lookup_props))
-     {
-       applied = accel.apply (c, subtable_count, use_cache);
-     }
+    if (!accel.digest.may_have (cur.codepoint) ||
+	!(cur.mask & c->lookup_mask))
+    {
+      /* Skip to the next glyph the lookup may apply to. */
+      unsigned next = find_next_candidate (accel.digest, c->lookup_mask,
+					   buffer->info, buffer->idx + 1, buffer->len);
+      (void) buffer->next_glyphs (next - buffer->idx);
+      continue;
+    }
+
+    if (c->check_glyph_property (&cur, c->lookup_props))
+      applied = accel.apply (c, subtable_count, use_cache);
 
     if (applied)
       ret = true;
@@ -2021,6 +2105,9 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
 
   OT::hb_ot_apply_context_t c (table_index, font, buffer, proxy.accel.get_blob (), var_store_cache);
   c.set_recurse_func (Proxy::Lookup::template dispatch_recurse_func<OT::hb_ot_apply_context_t>);
+  bool digest_stale = false;
+  static constexpr int MAX_RECOLLECT_BUDGET = 8;
+  int recollect_budget = MAX_RECOLLECT_BUDGET;
 
   for (unsigned int stage_index = 0; stage_index < stages[table_index].length; stage_index++)
   {
@@ -2040,8 +2127,28 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
       /* c.digest is a digest of all the current glyphs in the buffer
        * (plus some past glyphs).
        *
-       * Only try applying the lookup if there is any overlap. */
-      if (accel->digest.may_intersect (c.digest))
+       * Only try applying the lookup if there is any overlap.
+       *
+       * Substitutions only ever add to the digest, so after a GSUB lookup
+       * applies it accumulates glyphs that are gone from the buffer.  In
+       * that case, before walking the buffer for a lookup that seems to
+       * overlap, recollect the digest and check again; that is much
+       * cheaper than the walk, and only done when it may save one.
+       *
+       * On long buffers the digest tends to be saturated either way; stop
+       * recollecting once doing so keeps failing to skip lookups. */
+      bool may_apply = accel->digest.may_intersect (c.digest);
+      if (may_apply && digest_stale && recollect_budget > 0)
+      {
+	buffer->collect_codepoints (c.digest);
+	digest_stale = false;
+	may_apply = accel->digest.may_intersect (c.digest);
+	if (may_apply)
+	  recollect_budget--;
+	else if (recollect_budget < MAX_RECOLLECT_BUDGET)
+	  recollect_budget++;
+      }
+      if (may_apply)
       {
 	c.set_lookup_index (lookup_index);
 	c.set_lookup_mask (lookup.mask, false);
@@ -2051,9 +2158,11 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
 	c.set_per_syllable (lookup.per_syllable, false);
 	/* apply_string's set_lookup_props initializes the iterators. */
 
-	apply_string<Proxy> (&c,
-			     proxy.accel.table->get_lookup (lookup_index),
-			     *accel);
+	if (apply_string<Proxy> (&c,
+				 proxy.accel.table->get_lookup (lookup_index),
+				 *accel) &&
+	    Proxy::table_index == 0u)
+	  digest_stale = true;
       }
       else if (buffer->messaging ())
 	(void) buffer->message (font, "skipped lookup %u feature '%c%c%c%c' because no glyph matches", lookup_index, HB_UNTAG (lookup.feature_tag));
@@ -2068,6 +2177,7 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
       {
 	/* Refresh working buffer digest since buffer changed. */
 	buffer->collect_codepoints (c.digest);
+	digest_stale = false;
       }
     }
   }
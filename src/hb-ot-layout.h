@@ -316,6 +316,10 @@ HB_EXTERN unsigned int
 hb_ot_layout_table_get_lookup_count (hb_face_t    *face,
 				     hb_tag_t      table_tag);
 
+HB_EXTERN unsigned int
+hb_ot_layout_table_get_coverage_bitmap_memory (hb_face_t    *face,
+					       hb_tag_t      table_tag);
+
 HB_EXTERN void
 hb_ot_layout_collect_features (hb_face_t      *face,
 			       hb_tag_t        table_tag,
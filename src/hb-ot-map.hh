@@ -170,6 +170,13 @@ struct hb_ot_map_t
 					     unsigned int *tag_count, /* IN/OUT */
 					     hb_tag_t     *tags /* OUT */) const;
 
+  unsigned get_memory_usage () const
+  {
+    return features.get_size () +
+	   lookups[0].get_size () + lookups[1].get_size () +
+	   stages[0].get_size () + stages[1].get_size ();
+  }
+
   public:
   hb_tag_t chosen_script[2];
   bool found_script[2];
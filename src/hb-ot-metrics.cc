@@ -138,6 +138,10 @@ hb_ot_metrics_get_position (hb_font_t           *font,
 			    hb_ot_metrics_tag_t  metrics_tag,
 			    hb_position_t       *position     /* OUT.  May be NULL. */)
 {
+  if (const hb_frozen_instance_t *frozen = font->get_frozen_instance ())
+    if (frozen->get_metric (metrics_tag, position))
+      return true;
+
   hb_face_t *face = font->face;
   switch ((unsigned) metrics_tag)
   {
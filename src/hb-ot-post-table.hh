@@ -29,6 +29,7 @@
 
 #include "hb-open-type.hh"
 #include "hb-ot-var-mvar-table.hh"
+#include "hb-face-snapshot.hh"
 
 #define HB_STRING_ARRAY_NAME format1_names
 #define HB_STRING_ARRAY_LIST "hb-ot-post-macroman.hh"
@@ -154,6 +155,11 @@ struct post
 	   index_to_offset.length < 65535 && data < end && data + *data < end;
 	   data += 1 + *data)
 	index_to_offset.push (data - pool);
+
+      unsigned snapshot_length;
+      auto *snapshot = (const hb_face_snapshot_glyph_names_t *) face->get_snapshot_section (tableTag, &snapshot_length);
+      if (snapshot && snapshot->count == get_glyph_count ())
+	snapshot_gids = snapshot->gids;
     }
     ~accelerator_t ()
     {
@@ -183,6 +189,29 @@ struct post
 
       if (unlikely (!len)) return false;
 
+      const uint16_t *gids = get_gids_sorted_by_name ().arrayZ;
+      if (unlikely (!gids))
+	return false; /* Anything better?! */
+
+      hb_bytes_t st (name, len);
+      auto* gid = hb_bsearch (st, gids, count, sizeof (gids[0]), cmp_key, (void *) this);
+      if (gid)
+      {
+	*glyph = *gid;
+	return true;
+      }
+
+      return false;
+    }
+
+    /* Glyph ids ordered by name; from the attached snapshot if any,
+     * else sorted on first use. */
+    hb_array_t<const uint16_t> get_gids_sorted_by_name () const
+    {
+      unsigned int count = get_glyph_count ();
+      if (snapshot_gids)
+	return hb_array (snapshot_gids, count);
+
     retry:
       uint16_t *gids = gids_sorted_by_name.get_acquire ();
 
@@ -190,7 +219,7 @@ struct post
       {
 	gids = (uint16_t *) hb_malloc (count * sizeof (gids[0]));
 	if (unlikely (!gids))
-	  return false; /* Anything better?! */
+	  return hb_array_t<const uint16_t> ();
 
 	for (unsigned int i = 0; i < count; i++)
 	  gids[i] = i;
@@ -203,15 +232,23 @@ struct post
 	}
       }
 
-      hb_bytes_t st (name, len);
-      auto* gid = hb_bsearch (st, gids, count, sizeof (gids[0]), cmp_key, (void *) this);
-      if (gid)
-      {
-	*glyph = *gid;
-	return true;
-      }
+      return hb_array ((const uint16_t *) gids, count);
+    }
 
-      return false;
+    unsigned get_memory_usage () const
+    {
+      unsigned size = sizeof (*this) + index_to_offset.get_size ();
+      if (gids_sorted_by_name.get_acquire ())
+	size += get_glyph_count () * sizeof (uint16_t);
+      return size;
+    }
+
+    /* Frees the name index, to be rebuilt on next use.  Must not run
+     * concurrently with any other use of the face. */
+    void trim () const
+    {
+      hb_free (gids_sorted_by_name.get_relaxed ());
+      gids_sorted_by_name.set_relaxed (nullptr);
     }
 
     hb_blob_ptr_t<post> table;
@@ -291,6 +328,7 @@ struct post
     hb_vector_t<uint32_t> index_to_offset;
     const uint8_t *pool = nullptr;
     mutable hb_atomic_t<uint16_t *> gids_sorted_by_name;
+    const uint16_t *snapshot_gids = nullptr;
   };
 
   bool has_data () const { return version.to_int (); }
@@ -435,7 +435,8 @@ _hb_ot_shaper_font_data_create (hb_font_t *font)
     return (hb_ot_font_data_t *) HB_SHAPER_DATA_SUCCEEDED;
 
   const OT::ItemVariationStore &var_store = font->face->table.GDEF->table->get_var_store ();
-  auto *cache = (hb_ot_font_data_t *) var_store.create_cache ();
+  auto *cache = (hb_ot_font_data_t *) var_store.create_cache (font->coords, font->num_coords,
+							     /* bake_deltas */ font->frozen_instance);
   return cache ? cache : (hb_ot_font_data_t *) HB_SHAPER_DATA_SUCCEEDED;
 }
 
@@ -64,6 +64,8 @@ hb_syllabic_insert_dotted_circles (hb_font_t *font,
   buffer->clear_output ();
 
   buffer->idx = 0;
+  /* Syllable serials wrap around, so compare against the previous glyph's
+   * syllable, not the last broken one, to find where syllables start. */
   unsigned int last_syllable = 0;
   while (buffer->idx < buffer->len && buffer->successful)
   {
@@ -89,7 +91,10 @@ hb_syllabic_insert_dotted_circles (hb_font_t *font,
       (void) buffer->output_info (ginfo);
     }
     else
+    {
+      last_syllable = syllable;
       (void) buffer->next_glyph ();
+    }
   }
   buffer->sync ();
 
@@ -327,7 +327,7 @@ struct avar
 
     const auto &varidx_map = this+v2.varIdxMap;
     const auto &var_store = this+v2.varStore;
-    auto *var_store_cache = var_store.create_cache ();
+    auto *var_store_cache = var_store.create_cache (coords, coords_length);
 
     hb_vector_t<int> out;
     out.alloc (coords_length);
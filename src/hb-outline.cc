@@ -31,6 +31,7 @@
 
 #include "hb-outline.hh"
 
+#include "hb-font.hh"
 #include "hb-machinery.hh"
 
 
@@ -324,4 +325,176 @@ hb_outline_recording_pen_get_funcs ()
 }
 
 
+
+/*
+ * hb_outline_cache_t
+ */
+
+bool
+hb_outline_cache_t::draw (hb_font_t *font,
+			  hb_codepoint_t glyph,
+			  hb_draw_funcs_t *pen, void *pen_data)
+{
+  auto coords = hb_array ((const int *) font->coords, font->num_coords);
+  uint32_t hash = coords.hash () * 31u + hb_hash (glyph);
+
+  entry_t *entry = lookup (font, hash, glyph, coords);
+  if (!entry)
+  {
+    entry = (entry_t *) hb_calloc (1, sizeof (entry_t));
+    if (unlikely (!entry))
+      return font->draw_glyph_or_fail (glyph, pen, pen_data);
+    new (entry) entry_t ();
+    entry->ref_count = 1;
+    entry->hash = hash;
+    entry->glyph = glyph;
+
+    hb_outline_t outline;
+    entry->ret = font->draw_glyph_or_fail (glyph,
+					   hb_outline_recording_pen_get_funcs (), &outline);
+
+    /* Copy to exactly-sized storage, as entries can live long. */
+    auto &points = entry->outline.points;
+    auto &contours = entry->outline.contours;
+    if (unlikely (!entry->coords.alloc_exact (coords.length) ||
+		  !points.alloc_exact (outline.points.length) ||
+		  !contours.alloc_exact (outline.contours.length) ||
+		  outline.points.in_error () ||
+		  outline.contours.in_error ()))
+    {
+      release (entry);
+      return font->draw_glyph_or_fail (glyph, pen, pen_data);
+    }
+    entry->coords.extend (coords);
+    points.extend (outline.points.as_array ());
+    contours.extend (outline.contours.as_array ());
+    entry->memory = sizeof (entry_t)
+		  + coords.length * sizeof (coords[0])
+		  + points.length * sizeof (points[0])
+		  + contours.length * sizeof (contours[0]);
+
+    insert (font, entry);
+  }
+
+  entry->outline.replay (pen, pen_data);
+  bool ret = entry->ret;
+  release (entry);
+  return ret;
+}
+
+/* On hit, returns a new reference to the entry. */
+hb_outline_cache_t::entry_t *
+hb_outline_cache_t::lookup (hb_font_t *font,
+			    uint32_t hash,
+			    hb_codepoint_t glyph,
+			    hb_array_t<const int> coords)
+{
+  hb_lock_t lock (this->lock);
+
+  check_serial (font);
+
+  entry_t *entry = entries.get (hash);
+  if (!entry || !entry->matches (hash, glyph, coords))
+  {
+    misses++;
+    return nullptr;
+  }
+
+  lru.move_to_front (entry);
+  entry->ref_count.inc ();
+  hits++;
+  return entry;
+}
+
+/* Takes a new reference to the entry if it is kept. */
+void
+hb_outline_cache_t::insert (hb_font_t *font, entry_t *entry)
+{
+  hb_lock_t lock (this->lock);
+
+  check_serial (font);
+
+  if (entry->memory > max_memory)
+    return;
+
+  entry_t *old = entries.get (entry->hash);
+  if (old)
+  {
+    if (old->matches (entry->hash, entry->glyph, entry->coords.as_array ()))
+      return; /* Another thread beat us to it. */
+    remove (old);
+    evictions++;
+  }
+
+  while (lru.tail && this->memory + entry->memory > max_memory)
+  {
+    remove (lru.tail);
+    evictions++;
+  }
+
+  if (unlikely (!entries.set (entry->hash, entry)))
+    return;
+  entry->ref_count.inc ();
+  lru.push_front (entry);
+  this->memory += entry->memory;
+}
+
+/* Serials only ever go up.  Setting the variation coordinates
+ * increments the serial of the font exactly once; keep the cache
+ * if that was the only change, since coordinates are part of the
+ * key.  Anything else flushes the cache. */
+void
+hb_outline_cache_t::check_serial (hb_font_t *font)
+{
+  unsigned current = font->serial.get_acquire ();
+  unsigned current_parent = 0;
+  for (hb_font_t *parent = font->parent; parent; parent = parent->parent)
+    current_parent += parent->serial.get_acquire ();
+
+  if (current == serial && current_parent == parent_serial)
+    return;
+
+  bool coords_only = current_parent == parent_serial &&
+		     current == serial + 1 &&
+		     font->serial_coords.get_acquire () == current;
+  if (!coords_only)
+    clear ();
+
+  serial = current;
+  parent_serial = current_parent;
+}
+
+void
+hb_outline_cache_t::clear ()
+{
+  while (lru.tail)
+    remove (lru.tail);
+}
+
+void
+hb_outline_cache_t::set_max_memory (unsigned max_memory_)
+{
+  hb_lock_t lock (this->lock);
+  max_memory = max_memory_;
+  while (lru.tail && memory > max_memory)
+  {
+    remove (lru.tail);
+    evictions++;
+  }
+}
+
+void
+hb_outline_cache_t::get_stats (unsigned *hits_,
+			       unsigned *misses_,
+			       unsigned *evictions_,
+			       unsigned *memory_)
+{
+  hb_lock_t lock (this->lock);
+  if (hits_) *hits_ = hits;
+  if (misses_) *misses_ = misses;
+  if (evictions_) *evictions_ = evictions;
+  if (memory_) *memory_ = memory;
+}
+
+
 #endif
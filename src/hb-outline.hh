@@ -27,7 +27,10 @@
 
 #include "hb.hh"
 
+#include "hb-cache.hh"
 #include "hb-draw.hh"
+#include "hb-map.hh"
+#include "hb-mutex.hh"
 
 
 struct hb_outline_point_t
@@ -81,4 +84,107 @@ HB_INTERNAL hb_draw_funcs_t *
 hb_outline_recording_pen_get_funcs ();
 
 
+/* A bounded cache of glyph outlines, attached to a font.
+ *
+ * Outlines are recorded, scaled and with synthetic emboldening and
+ * slanting applied, using the recording pen, and replayed to the
+ * caller's pen.  Entries are keyed by glyph and variation coordinates,
+ * such that outlines of several instances can be cached at the same
+ * time.  Any other font change, in the font or any of its parents,
+ * flushes the whole cache.
+ *
+ * Entries are kept in LRU order and evicted when the memory budget
+ * is exceeded.  They are reference-counted, such that replaying does
+ * not need to hold the lock, and can call back into HarfBuzz.
+ */
+
+struct hb_outline_cache_t
+{
+  struct entry_t
+  {
+    entry_t *prev; /* Toward most-recently-used. */
+    entry_t *next; /* Toward least-recently-used. */
+    hb_atomic_t<int> ref_count;
+    uint32_t hash;
+    hb_codepoint_t glyph;
+    bool ret;
+    unsigned memory;
+    hb_vector_t<int> coords;
+    hb_outline_t outline;
+
+    bool matches (uint32_t hash_,
+		  hb_codepoint_t glyph_,
+		  hb_array_t<const int> coords_) const
+    { return hash == hash_ && glyph == glyph_ && coords.as_array () == coords_; }
+  };
+
+  static hb_outline_cache_t *create (unsigned max_memory)
+  {
+    hb_outline_cache_t *cache = (hb_outline_cache_t *) hb_calloc (1, sizeof (hb_outline_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    new (cache) hb_outline_cache_t ();
+    cache->max_memory = max_memory;
+    return cache;
+  }
+  static void destroy (hb_outline_cache_t *cache)
+  {
+    if (!cache)
+      return;
+    cache->~hb_outline_cache_t ();
+    hb_free (cache);
+  }
+
+  ~hb_outline_cache_t () { clear (); }
+
+  /* Draws glyph of font to pen, from the cache if possible. */
+  HB_INTERNAL bool draw (hb_font_t *font,
+			 hb_codepoint_t glyph,
+			 hb_draw_funcs_t *pen, void *pen_data);
+
+  HB_INTERNAL void set_max_memory (unsigned max_memory);
+
+  HB_INTERNAL void get_stats (unsigned *hits,
+			      unsigned *misses,
+			      unsigned *evictions,
+			      unsigned *memory);
+
+  private:
+
+  HB_INTERNAL entry_t *lookup (hb_font_t *font,
+			       uint32_t hash,
+			       hb_codepoint_t glyph,
+			       hb_array_t<const int> coords);
+  HB_INTERNAL void insert (hb_font_t *font, entry_t *entry);
+  HB_INTERNAL void check_serial (hb_font_t *font);
+  HB_INTERNAL void clear ();
+
+  void remove (entry_t *entry)
+  {
+    lru.remove (entry);
+    entries.del (entry->hash);
+    memory -= entry->memory;
+    release (entry);
+  }
+  static void release (entry_t *entry)
+  {
+    if (entry->ref_count.dec () != 1)
+      return;
+    entry->~entry_t ();
+    hb_free (entry);
+  }
+
+  hb_mutex_t lock;
+  hb_hashmap_t<uint32_t, entry_t *> entries;
+  hb_lru_list_t<entry_t> lru;
+  unsigned serial = 0;
+  unsigned parent_serial = 0;
+  unsigned max_memory = 0;
+  unsigned memory = 0;
+  unsigned hits = 0;
+  unsigned misses = 0;
+  unsigned evictions = 0;
+};
+
+
 #endif /* HB_OUTLINE_HH */
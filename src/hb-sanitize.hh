@@ -117,6 +117,19 @@
 #define HB_SANITIZE_MAX_SUBTABLES 0x4000
 #endif
 
+HB_INTERNAL bool
+_hb_face_sanitize_cache_lookup (const hb_face_t *face,
+				hb_tag_t         tag,
+				const hb_blob_t *blob,
+				unsigned int     num_glyphs,
+				bool             lazy,
+				uint64_t        *digest /* OUT */);
+HB_INTERNAL void
+_hb_face_sanitize_cache_record (const hb_face_t *face,
+				hb_tag_t         tag,
+				uint64_t         digest,
+				unsigned int     length);
+
 struct hb_sanitize_context_t :
        hb_dispatch_context_t<hb_sanitize_context_t, bool, HB_DEBUG_SANITIZE>
 {
@@ -497,7 +510,22 @@ struct hb_sanitize_context_t :
   {
     if (!num_glyphs_set)
       set_num_glyphs (hb_face_get_glyph_count (face));
-    return sanitize_blob<Type> (hb_face_reference_table (face, tableTag));
+    hb_blob_t *blob = hb_face_reference_table (face, tableTag);
+
+    uint64_t digest;
+    if (_hb_face_sanitize_cache_lookup (face, tableTag, blob, num_glyphs, lazy_some_gpos, &digest))
+    {
+      hb_blob_make_immutable (blob);
+      return blob;
+    }
+
+    blob = sanitize_blob<Type> (blob);
+
+    /* Only record tables that passed untouched; edited ones live in a copy. */
+    if (digest && !writable && blob->length)
+      _hb_face_sanitize_cache_record (face, tableTag, digest, blob->length);
+
+    return blob;
   }
 
   const char *start, *end;
@@ -158,6 +158,18 @@ struct hb_set_digest_t
     return true;
   }
 
+  /* Same as may_have(), but without early returns, such that a loop
+   * testing several glyphs at once compiles to straight-line (and,
+   * where the target allows, vectorized) code. */
+  HB_ALWAYS_INLINE
+  bool may_have_branchless (hb_codepoint_t g) const
+  {
+    mask_t r = one;
+    for (unsigned i = 0; i < n; i++)
+      r &= masks[i] >> ((g >> hb_set_digest_shifts[i]) & mb1);
+    return r;
+  }
+
   bool may_intersect (const hb_set_digest_t &o) const
   {
     for (unsigned i = 0; i < n; i++)
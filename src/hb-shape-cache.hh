@@ -0,0 +1,363 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Google Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_SHAPE_CACHE_HH
+#define HB_SHAPE_CACHE_HH
+
+#include "hb.hh"
+
+#include "hb-buffer.hh"
+#include "hb-cache.hh"
+#include "hb-font.hh"
+#include "hb-map.hh"
+#include "hb-mutex.hh"
+#include "hb-vector.hh"
+
+
+/* A bounded cache of complete shaping results, attached to a font.
+ *
+ * The key is everything, other than the font, that influences the
+ * output of hb_shape_full(): the text and its context, segment
+ * properties, buffer flags and settings, and user features.  Font
+ * changes are detected using the serial numbers of the font and its
+ * parents, and flush the whole cache.
+ *
+ * Cluster values are stored as indices into the input text, such that
+ * a cached result can be replayed for a buffer with different (but
+ * strictly increasing) input cluster values.
+ *
+ * Entries are kept in LRU order and evicted when the memory budget
+ * is exceeded.  All access is serialized on a mutex; the critical
+ * sections are short: a hash lookup and a copy of a handful of glyphs.
+ */
+
+struct hb_shape_cache_t
+{
+  /* Only cache "words".  Longer buffers are unlikely to repeat, and
+   * copying them around on a miss would just be overhead. */
+  static constexpr unsigned MAX_LENGTH = 64;
+  static constexpr unsigned MAX_FEATURES = 32;
+  static constexpr unsigned MAX_KEY_LENGTH = 18
+					   + 2 * hb_buffer_t::CONTEXT_LENGTH
+					   + 2 * MAX_FEATURES
+					   + MAX_LENGTH;
+
+  struct key_t
+  {
+    uint32_t hash;
+    unsigned length;
+    uint32_t v[MAX_KEY_LENGTH];
+    unsigned num_clusters;
+    uint32_t clusters[MAX_LENGTH]; /* Input clusters; not part of key. */
+
+    void push (uint32_t x) { v[length++] = x; }
+    void push_pointer (const void *p)
+    {
+      uint64_t x = (uint64_t) (uintptr_t) p;
+      push ((uint32_t) x);
+      push ((uint32_t) (x >> 32));
+    }
+
+    hb_array_t<const uint32_t> as_array () const { return hb_array (v, length); }
+  };
+
+  struct entry_t
+  {
+    entry_t *prev; /* Toward most-recently-used. */
+    entry_t *next; /* Toward least-recently-used. */
+    uint32_t hash;
+    uint32_t random_state;
+    unsigned memory;
+    hb_vector_t<uint32_t> key;
+    hb_vector_t<hb_glyph_info_t> info; /* Cluster is index into input. */
+    hb_vector_t<hb_glyph_position_t> pos;
+
+    bool matches (const key_t &k) const
+    { return hash == k.hash && key.as_array () == k.as_array (); }
+  };
+
+  static hb_shape_cache_t *create (unsigned max_memory)
+  {
+    hb_shape_cache_t *cache = (hb_shape_cache_t *) hb_calloc (1, sizeof (hb_shape_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    new (cache) hb_shape_cache_t ();
+    cache->max_memory = max_memory;
+    return cache;
+  }
+  static void destroy (hb_shape_cache_t *cache)
+  {
+    if (!cache)
+      return;
+    cache->~hb_shape_cache_t ();
+    hb_free (cache);
+  }
+
+  ~hb_shape_cache_t () { clear (); }
+
+  /* Serials only ever go up, so their sum changes whenever any font in
+   * the parent chain changes. */
+  static unsigned font_serial (hb_font_t *font)
+  {
+    unsigned serial = 0;
+    for (; font; font = font->parent)
+      serial += font->serial;
+    return serial;
+  }
+
+  /* Fills in key; returns false if the buffer is not eligible for caching. */
+  static bool
+  make_key (const hb_buffer_t  *buffer,
+	    const hb_feature_t *features,
+	    unsigned int        num_features,
+	    key_t              &key)
+  {
+    if (buffer->content_type != HB_BUFFER_CONTENT_TYPE_UNICODE ||
+	buffer->len > MAX_LENGTH ||
+	num_features > MAX_FEATURES ||
+	(buffer->flags & HB_BUFFER_FLAG_VERIFY)
+#ifndef HB_NO_BUFFER_MESSAGE
+	|| buffer->message_func
+#endif
+       )
+      return false;
+
+    /* Feature ranges are expressed in cluster values, which we remap;
+     * only cache global features. */
+    for (unsigned i = 0; i < num_features; i++)
+      if (features[i].start != HB_FEATURE_GLOBAL_START ||
+	  features[i].end != HB_FEATURE_GLOBAL_END)
+	return false;
+
+    key.length = 0;
+    key.push (buffer->len);
+    key.push (buffer->props.direction);
+    key.push (buffer->props.script);
+    key.push_pointer (buffer->props.language);
+    key.push_pointer (buffer->unicode);
+    key.push (buffer->flags);
+    key.push (buffer->cluster_level);
+    key.push (buffer->replacement);
+    key.push (buffer->invisible);
+    key.push (buffer->not_found);
+    key.push (buffer->not_found_variation_selector);
+    key.push (buffer->random_state);
+    key.push (num_features);
+    for (unsigned i = 0; i < num_features; i++)
+    {
+      key.push (features[i].tag);
+      key.push (features[i].value);
+    }
+    for (unsigned side = 0; side < 2; side++)
+    {
+      key.push (buffer->context_len[side]);
+      for (unsigned i = 0; i < buffer->context_len[side]; i++)
+	key.push (buffer->context[side][i]);
+    }
+
+    const hb_glyph_info_t *info = buffer->info;
+    key.num_clusters = buffer->len;
+    for (unsigned i = 0; i < buffer->len; i++)
+    {
+      if (i && info[i].cluster <= info[i - 1].cluster)
+	return false;
+      key.push (info[i].codepoint);
+      key.clusters[i] = info[i].cluster;
+    }
+
+    key.hash = key.as_array ().hash ();
+    return true;
+  }
+
+  /* On hit, replaces buffer contents with the cached glyphs. */
+  bool lookup (hb_font_t *font, const key_t &key, hb_buffer_t *buffer)
+  {
+    hb_lock_t lock (this->lock);
+
+    check_serial (font);
+
+    entry_t *entry = entries.get (key.hash);
+    if (!entry || !entry->matches (key))
+    {
+      misses++;
+      return false;
+    }
+
+    unsigned count = entry->info.length;
+    if (unlikely (!buffer->ensure (count)))
+    {
+      misses++;
+      return false;
+    }
+
+    const hb_glyph_info_t *src = entry->info.arrayZ;
+    hb_glyph_info_t *info = buffer->info;
+    for (unsigned i = 0; i < count; i++)
+    {
+      info[i] = src[i];
+      info[i].cluster = key.clusters[src[i].cluster];
+    }
+    hb_memcpy (buffer->pos, entry->pos.arrayZ, count * sizeof (buffer->pos[0]));
+    buffer->len = count;
+    buffer->have_output = false;
+    buffer->have_positions = true;
+    buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
+    buffer->shaping_failed = false;
+    buffer->random_state = entry->random_state;
+
+    lru.move_to_front (entry);
+    hits++;
+    return true;
+  }
+
+  /* Records the result of shaping the text described by key. */
+  void insert (hb_font_t *font, const key_t &key, const hb_buffer_t *buffer)
+  {
+    unsigned count = buffer->len;
+    unsigned memory = sizeof (entry_t)
+		    + key.length * sizeof (uint32_t)
+		    + count * (sizeof (hb_glyph_info_t) + sizeof (hb_glyph_position_t));
+    if (memory > max_memory)
+      return;
+
+    entry_t *entry = (entry_t *) hb_calloc (1, sizeof (entry_t));
+    if (unlikely (!entry))
+      return;
+    new (entry) entry_t ();
+
+    entry->hash = key.hash;
+    entry->random_state = buffer->random_state;
+    entry->memory = memory;
+    entry->key.extend (key.as_array ());
+    entry->info.extend (hb_array (buffer->info, count));
+    entry->pos.extend (hb_array (buffer->pos, count));
+    if (unlikely (entry->key.in_error () ||
+		  entry->info.in_error () ||
+		  entry->pos.in_error ()))
+    {
+      destroy_entry (entry);
+      return;
+    }
+
+    for (auto &info : entry->info)
+    {
+      const uint32_t *p = hb_bsearch (info.cluster,
+				      key.clusters, key.num_clusters, sizeof (key.clusters[0]),
+				      _hb_cmp_operator<uint32_t, uint32_t>);
+      if (unlikely (!p))
+      {
+	destroy_entry (entry);
+	return;
+      }
+      info.cluster = p - key.clusters;
+    }
+
+    hb_lock_t lock (this->lock);
+
+    check_serial (font);
+
+    entry_t *old = entries.get (key.hash);
+    if (old)
+    {
+      if (old->matches (key))
+      {
+	/* Another thread beat us to it. */
+	destroy_entry (entry);
+	return;
+      }
+      remove (old);
+    }
+
+    while (lru.tail && this->memory + memory > max_memory)
+      remove (lru.tail);
+
+    if (unlikely (!entries.set (key.hash, entry)))
+    {
+      destroy_entry (entry);
+      return;
+    }
+    lru.push_front (entry);
+    this->memory += memory;
+  }
+
+  void set_max_memory (unsigned max_memory_)
+  {
+    hb_lock_t lock (this->lock);
+    max_memory = max_memory_;
+    while (lru.tail && memory > max_memory)
+      remove (lru.tail);
+  }
+
+  void get_stats (unsigned *hits_, unsigned *misses_, unsigned *memory_)
+  {
+    hb_lock_t lock (this->lock);
+    if (hits_) *hits_ = hits;
+    if (misses_) *misses_ = misses;
+    if (memory_) *memory_ = memory;
+  }
+
+  private:
+
+  void check_serial (hb_font_t *font)
+  {
+    unsigned current = font_serial (font);
+    if (current == serial)
+      return;
+    clear ();
+    serial = current;
+  }
+
+  void clear ()
+  {
+    while (lru.tail)
+      remove (lru.tail);
+  }
+
+  void remove (entry_t *entry)
+  {
+    lru.remove (entry);
+    entries.del (entry->hash);
+    memory -= entry->memory;
+    destroy_entry (entry);
+  }
+  static void destroy_entry (entry_t *entry)
+  {
+    entry->~entry_t ();
+    hb_free (entry);
+  }
+
+  hb_mutex_t lock;
+  hb_hashmap_t<uint32_t, entry_t *> entries;
+  hb_lru_list_t<entry_t> lru;
+  unsigned serial = 0;
+  unsigned max_memory = 0;
+  unsigned memory = 0;
+  unsigned hits = 0;
+  unsigned misses = 0;
+};
+
+
+#endif /* HB_SHAPE_CACHE_HH */
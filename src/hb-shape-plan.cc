@@ -165,6 +165,399 @@ hb_shape_plan_key_t::equal (const hb_shape_plan_key_t *other)
 	 this->shaper_func == other->shaper_func;
 }
 
+uint32_t
+hb_shape_plan_key_t::hash () const
+{
+  uint32_t h = hb_hash (props.direction);
+  h = h * 31 + hb_hash (props.script);
+  h = h * 31 + hb_hash ((const void *) props.language);
+  for (unsigned int i = 0; i < num_user_features; i++)
+  {
+    h = h * 31 + hb_hash (user_features[i].tag);
+    h = h * 31 + hb_hash (user_features[i].value);
+    h = h * 31 + (user_features[i].start == HB_FEATURE_GLOBAL_START &&
+		  user_features[i].end   == HB_FEATURE_GLOBAL_END);
+  }
+#ifndef HB_NO_OT_SHAPE
+  h = h * 31 + hb_hash (ot.variations_index[0]);
+  h = h * 31 + hb_hash (ot.variations_index[1]);
+#endif
+  h = h * 31 + hb_hash ((const void *) shaper_func);
+  return h;
+}
+
+
+/*
+ * hb_shape_plan_cache_t
+ */
+
+hb_shape_plan_cache_t *
+hb_shape_plan_cache_t::create ()
+{
+  hb_shape_plan_cache_t *cache = (hb_shape_plan_cache_t *) hb_calloc (1, sizeof (hb_shape_plan_cache_t));
+  if (unlikely (!cache))
+    return nullptr;
+  new (cache) hb_shape_plan_cache_t ();
+  return cache;
+}
+
+void
+hb_shape_plan_cache_t::destroy (hb_shape_plan_cache_t *cache)
+{
+  if (!cache)
+    return;
+  cache->~hb_shape_plan_cache_t ();
+  hb_free (cache);
+}
+
+hb_shape_plan_cache_t::entry_t *
+hb_shape_plan_cache_t::find (table_t *table, hb_shape_plan_key_t *key, uint32_t hash,
+			     hb_shape_plan_t **shape_plan)
+{
+  if (!table)
+    return nullptr;
+  /* Writers move entries around while lookups probe; bound the probe
+   * rather than rely on meeting an empty slot. */
+  unsigned i = hash & table->mask;
+  for (unsigned n = 0; n <= table->mask; n++, i = (i + 1) & table->mask)
+  {
+    entry_t *entry = &table->entries[i];
+    hb_shape_plan_t *plan = entry->shape_plan.get_acquire ();
+    if (!plan)
+      return nullptr;
+    if (entry->hash.get_relaxed () == hash && plan->key.equal (key))
+    {
+      *shape_plan = plan;
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+hb_shape_plan_t *
+hb_shape_plan_cache_t::lookup (hb_shape_plan_key_t *key, uint32_t hash)
+{
+  /* Register with the current epoch.  If it moved on before we were
+   * counted, the writer that moved it may have missed us; retry.  The
+   * check is a read-modify-write, so it sees the latest epoch.  See
+   * reclaim (). */
+  unsigned e;
+  for (;;)
+  {
+    e = epoch.get_relaxed ();
+    readers[e & 1].inc ();
+    if (epoch.add (0) == e)
+      break;
+    readers[e & 1].dec ();
+  }
+
+  hb_shape_plan_t *shape_plan = nullptr;
+  if (entry_t *entry = find (table.get_acquire (), key, hash, &shape_plan))
+  {
+    /* Every hit or miss moves the clock forward. */
+    entry->stamp.set_relaxed (hits.inc () + 1 + misses.get_relaxed ());
+    hb_shape_plan_reference (shape_plan);
+  }
+
+  if (readers[e & 1].dec () == 1 && reclaimable.get_relaxed ())
+  {
+    hb_lock_t lock (this->lock);
+    reclaim ();
+  }
+
+  if (!shape_plan)
+    misses.inc ();
+  return shape_plan;
+}
+
+hb_shape_plan_t *
+hb_shape_plan_cache_t::insert (hb_shape_plan_t *shape_plan, uint32_t hash)
+{
+  hb_lock_t lock (this->lock);
+
+  hb_shape_plan_t *existing = nullptr;
+  if (find (table.get_relaxed (), &shape_plan->key, hash, &existing))
+  {
+    /* Another thread beat us to it. */
+    hb_shape_plan_destroy (shape_plan);
+    return hb_shape_plan_reference (existing);
+  }
+
+  if (!capacity ||
+      (count >= capacity && !evict ()) ||
+      unlikely (!grow ()))
+  {
+    reclaim ();
+    return shape_plan;
+  }
+
+  put (table.get_relaxed (), shape_plan, hash, hits.get_relaxed () + misses.get_relaxed ());
+  count++;
+  reclaim ();
+
+  return hb_shape_plan_reference (shape_plan);
+}
+
+hb_shape_plan_cache_t::table_t *
+hb_shape_plan_cache_t::create_table (unsigned size)
+{
+  table_t *table = (table_t *) hb_calloc (1, sizeof (table_t) + (size - 1) * sizeof (entry_t));
+  if (likely (table))
+    table->mask = size - 1;
+  return table;
+}
+
+/* Stores an entry in the first free slot of its probe run.  The plan is
+ * published last, as lookups read it first. */
+void
+hb_shape_plan_cache_t::put (table_t *table, hb_shape_plan_t *shape_plan, unsigned hash, unsigned stamp)
+{
+  unsigned i = hash & table->mask;
+  while (table->entries[i].shape_plan.get_relaxed ())
+    i = (i + 1) & table->mask;
+  entry_t &entry = table->entries[i];
+  entry.hash.set_relaxed (hash);
+  entry.stamp.set_relaxed (stamp);
+  entry.shape_plan.cmpexch (nullptr, shape_plan);
+}
+
+/* Makes room for one more entry, keeping the table at most half full.
+ * Called with the lock held. */
+bool
+hb_shape_plan_cache_t::grow ()
+{
+  table_t *old_table = table.get_relaxed ();
+  unsigned old_size = old_table ? old_table->mask + 1 : 0;
+  if ((count + 1) * 2 <= old_size)
+    return true;
+
+  if (unlikely (old_table && !retiring.tables.alloc (retiring.tables.length + 1)))
+    return false;
+  table_t *new_table = create_table (hb_max (8u, old_size * 2));
+  if (unlikely (!new_table))
+    return false;
+
+  if (old_table)
+    for (unsigned i = 0; i <= old_table->mask; i++)
+    {
+      const entry_t &entry = old_table->entries[i];
+      if (hb_shape_plan_t *shape_plan = entry.shape_plan.get_relaxed ())
+	put (new_table, shape_plan, entry.hash.get_relaxed (), entry.stamp.get_relaxed ());
+    }
+
+  table.cmpexch (old_table, new_table);
+  if (old_table)
+    retiring.tables.push (old_table);
+  hand = 0;
+  return true;
+}
+
+/* Unpublishes the entry in slot i, retiring its plan, and shifts the
+ * rest of its probe run back so that probes keep finding them.  A lookup
+ * racing with the shift may miss an entry that is moving; that only
+ * costs it a new plan, which insert () then resolves to the cached one.
+ * Called with the lock held. */
+bool
+hb_shape_plan_cache_t::remove (unsigned i)
+{
+  if (unlikely (!retiring.plans.alloc (retiring.plans.length + 1)))
+    return false;
+
+  table_t *current = table.get_relaxed ();
+  unsigned mask = current->mask;
+  retiring.plans.push (current->entries[i].shape_plan.get_relaxed ());
+  current->entries[i].shape_plan.set_relaxed (nullptr);
+  count--;
+
+  for (unsigned j = (i + 1) & mask;; j = (j + 1) & mask)
+  {
+    entry_t &entry = current->entries[j];
+    hb_shape_plan_t *shape_plan = entry.shape_plan.get_relaxed ();
+    if (!shape_plan)
+      break;
+    /* Stays if slot i lies outside its probe run up to j. */
+    unsigned hash = entry.hash.get_relaxed ();
+    if (((j - hash) & mask) < ((j - i) & mask))
+      continue;
+
+    entry_t &hole = current->entries[i];
+    hole.hash.set_relaxed (hash);
+    hole.stamp.set_relaxed (entry.stamp.get_relaxed ());
+    hole.shape_plan.cmpexch (nullptr, shape_plan);
+    entry.shape_plan.set_relaxed (nullptr);
+    i = j;
+  }
+  return true;
+}
+
+/* Evicts the least recently used of the first few entries from the hand
+ * on, and moves the hand past it.  Called with the lock held. */
+bool
+hb_shape_plan_cache_t::evict ()
+{
+  table_t *current = table.get_relaxed ();
+  if (unlikely (!current || !count))
+    return false;
+
+  const unsigned max_samples = 8;
+  unsigned now = hits.get_relaxed () + misses.get_relaxed ();
+  unsigned victim = 0, oldest_age = 0, samples = 0;
+  unsigned i = hand & current->mask;
+  for (unsigned n = 0; n <= current->mask && samples < max_samples; n++, i = (i + 1) & current->mask)
+  {
+    const entry_t &entry = current->entries[i];
+    if (!entry.shape_plan.get_relaxed ())
+      continue;
+    unsigned age = now - entry.stamp.get_relaxed ();
+    if (!samples++ || age > oldest_age)
+    {
+      victim = i;
+      oldest_age = age;
+    }
+  }
+
+  hand = victim + 1;
+  return remove (victim);
+}
+
+/* Releases what is safe to release, and advances the epoch.  Called with
+ * the lock held, after every change.
+ *
+ * What was retired during the previous epoch may only be seen by lookups
+ * registered with its parity: later ones saw the epoch advance, which
+ * happened after it was unpublished, or retry.  Once those lookups have
+ * left it is released, and the epoch advances so that what was retired
+ * during the current one starts draining the same way.  The checks are
+ * read-modify-writes, so that a lookup registering after them
+ * synchronizes with us, and sees what we unpublished as gone. */
+void
+hb_shape_plan_cache_t::reclaim ()
+{
+  unsigned e = epoch.get_relaxed ();
+  if (!readers[(e + 1) & 1].add (0))
+  {
+    draining.release ();
+    if (!retiring.is_empty ())
+    {
+      hb_swap (draining, retiring);
+      epoch.inc ();
+      if (!readers[e & 1].add (0))
+	draining.release ();
+    }
+  }
+  reclaimable.set_relaxed (!draining.is_empty () || !retiring.is_empty ());
+}
+
+void
+hb_shape_plan_cache_t::retired_t::release ()
+{
+  for (hb_shape_plan_t *shape_plan : plans)
+    hb_shape_plan_destroy (shape_plan);
+  for (table_t *retired : tables)
+    hb_free (retired);
+  plans.resize (0);
+  tables.resize (0);
+}
+
+void
+hb_shape_plan_cache_t::clear ()
+{
+  if (table_t *current = table.get_relaxed ())
+  {
+    for (unsigned i = 0; i <= current->mask; i++)
+      if (hb_shape_plan_t *shape_plan = current->entries[i].shape_plan.get_relaxed ())
+	hb_shape_plan_destroy (shape_plan);
+    hb_free (current);
+    table.set_relaxed (nullptr);
+  }
+  count = 0;
+  hand = 0;
+
+  retiring.fini ();
+  draining.fini ();
+  reclaimable.set_relaxed (false);
+}
+
+void
+hb_shape_plan_cache_t::set_capacity (unsigned capacity_)
+{
+  hb_lock_t lock (this->lock);
+  capacity = capacity_;
+
+  /* Shrinking is rare; evict exactly the least recently used. */
+  unsigned now = hits.get_relaxed () + misses.get_relaxed ();
+  while (count > capacity)
+  {
+    table_t *current = table.get_relaxed ();
+    unsigned victim = 0, oldest_age = 0;
+    bool found = false;
+    for (unsigned i = 0; i <= current->mask; i++)
+    {
+      const entry_t &entry = current->entries[i];
+      if (!entry.shape_plan.get_relaxed ())
+	continue;
+      unsigned age = now - entry.stamp.get_relaxed ();
+      if (!found || age > oldest_age)
+      {
+	victim = i;
+	oldest_age = age;
+	found = true;
+      }
+    }
+    if (unlikely (!remove (victim)))
+      break;
+  }
+
+  table_t *current = table.get_relaxed ();
+  if (!capacity && current && !count &&
+      likely (retiring.tables.alloc (retiring.tables.length + 1)))
+  {
+    table.cmpexch (current, nullptr);
+    retiring.tables.push (current);
+  }
+
+  reclaim ();
+}
+
+void
+hb_shape_plan_cache_t::get_stats (unsigned *hits_, unsigned *misses_, unsigned *size_)
+{
+  hb_lock_t lock (this->lock);
+  if (hits_) *hits_ = hits.get_relaxed ();
+  if (misses_) *misses_ = misses.get_relaxed ();
+  if (size_) *size_ = count;
+}
+
+unsigned
+hb_shape_plan_cache_t::get_memory_usage ()
+{
+  hb_lock_t lock (this->lock);
+  unsigned total = sizeof (*this);
+  for (const retired_t *retired : {&retiring, &draining})
+  {
+    total += retired->tables.allocated * sizeof (table_t *) +
+	     retired->plans.allocated * sizeof (hb_shape_plan_t *);
+    for (table_t *retired_table : retired->tables)
+      total += get_table_size (retired_table);
+  }
+
+  table_t *current = table.get_relaxed ();
+  if (!current)
+    return total;
+  total += get_table_size (current);
+  for (unsigned i = 0; i <= current->mask; i++)
+  {
+    hb_shape_plan_t *shape_plan = current->entries[i].shape_plan.get_relaxed ();
+    if (!shape_plan)
+      continue;
+    total += sizeof (hb_shape_plan_t);
+#ifndef HB_NO_OT_SHAPE
+    total += shape_plan->ot.map.get_memory_usage ();
+#endif
+  }
+  return total;
+}
+
 
 /*
  * hb_shape_plan_t
@@ -463,6 +856,29 @@ hb_shape_plan_execute (hb_shape_plan_t    *shape_plan,
  * Caching
  */
 
+static hb_shape_plan_cache_t *
+_hb_face_get_shape_plan_cache (hb_face_t *face)
+{
+  if (unlikely (!hb_object_is_valid (face)))
+    return nullptr;
+
+retry:
+  hb_shape_plan_cache_t *cache = face->shape_plans;
+  if (likely (cache))
+    return cache;
+
+  cache = hb_shape_plan_cache_t::create ();
+  if (unlikely (!cache))
+    return nullptr;
+
+  if (unlikely (!face->shape_plans.cmpexch (nullptr, cache)))
+  {
+    hb_shape_plan_cache_t::destroy (cache);
+    goto retry;
+  }
+  return cache;
+}
+
 /**
  * hb_shape_plan_create_cached:
  * @face: #hb_face_t to use
@@ -525,56 +941,97 @@ hb_shape_plan_create_cached2 (hb_face_t                     *face,
 		  num_user_features,
 		  shaper_list);
 
-retry:
-  hb_face_t::plan_node_t *cached_plan_nodes = face->shape_plans;
+  hb_shape_plan_cache_t *cache = _hb_face_get_shape_plan_cache (face);
+  if (unlikely (!cache))
+    return hb_shape_plan_create2 (face, props,
+				  user_features, num_user_features,
+				  coords, num_coords,
+				  shaper_list);
 
-  bool dont_cache = !hb_object_is_valid (face);
+  hb_shape_plan_key_t key;
+  if (!key.init (false,
+		 face,
+		 props,
+		 user_features,
+		 num_user_features,
+		 coords,
+		 num_coords,
+		 shaper_list))
+    return hb_shape_plan_get_empty ();
 
-  if (likely (!dont_cache))
+  uint32_t hash = key.hash ();
+  hb_shape_plan_t *shape_plan = cache->lookup (&key, hash);
+  if (shape_plan)
   {
-    hb_shape_plan_key_t key;
-    if (!key.init (false,
-		   face,
-		   props,
-		   user_features,
-		   num_user_features,
-		   coords,
-		   num_coords,
-		   shaper_list))
-      return hb_shape_plan_get_empty ();
-
-    for (hb_face_t::plan_node_t *node = cached_plan_nodes; node; node = node->next)
-      if (node->shape_plan->key.equal (&key))
-      {
-	DEBUG_MSG_FUNC (SHAPE_PLAN, node->shape_plan, "fulfilled from cache");
-	return hb_shape_plan_reference (node->shape_plan);
-      }
+    DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "fulfilled from cache");
+    return shape_plan;
   }
 
-  hb_shape_plan_t *shape_plan = hb_shape_plan_create2 (face, props,
-						       user_features, num_user_features,
-						       coords, num_coords,
-						       shaper_list);
-
-  if (unlikely (dont_cache))
+  shape_plan = hb_shape_plan_create2 (face, props,
+				      user_features, num_user_features,
+				      coords, num_coords,
+				      shaper_list);
+  if (unlikely (!hb_object_is_valid (shape_plan)))
     return shape_plan;
 
-  hb_face_t::plan_node_t *node = (hb_face_t::plan_node_t *) hb_calloc (1, sizeof (hb_face_t::plan_node_t));
-  if (unlikely (!node))
-    return shape_plan;
+  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "inserted into cache");
+
+  return cache->insert (shape_plan, hash);
+}
 
-  node->shape_plan = shape_plan;
-  node->next = cached_plan_nodes;
+/**
+ * hb_face_set_shape_plan_cache_capacity:
+ * @face: #hb_face_t to work upon
+ * @capacity: maximum number of shape plans to cache
+ *
+ * Sets the maximum number of shape plans that
+ * hb_shape_plan_create_cached2(), and as such hb_shape(), keeps cached
+ * on @face.  When the cache is full, the least-recently-used plan is
+ * dropped.  Plans that are still referenced elsewhere stay valid.
+ *
+ * The default capacity is 256.  Passing zero disables caching, such
+ * that a new plan is created for every call.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_set_shape_plan_cache_capacity (hb_face_t    *face,
+				       unsigned int  capacity)
+{
+  hb_shape_plan_cache_t *cache = _hb_face_get_shape_plan_cache (face);
+  if (unlikely (!cache))
+    return;
 
-  if (unlikely (!face->shape_plans.cmpexch (cached_plan_nodes, node)))
+  cache->set_capacity (capacity);
+}
+
+/**
+ * hb_face_get_shape_plan_cache_stats:
+ * @face: #hb_face_t to work upon
+ * @hits: (out) (optional): number of plans served from the cache
+ * @misses: (out) (optional): number of plans that had to be created
+ * @size: (out) (optional): number of plans currently cached
+ *
+ * Fetches statistics of the shape-plan cache of @face.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_get_shape_plan_cache_stats (hb_face_t    *face,
+				    unsigned int *hits,
+				    unsigned int *misses,
+				    unsigned int *size)
+{
+  hb_shape_plan_cache_t *cache = face->shape_plans;
+  if (!cache)
   {
-    hb_shape_plan_destroy (shape_plan);
-    hb_free (node);
-    goto retry;
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (size) *size = 0;
+    return;
   }
-  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "inserted into cache");
 
-  return hb_shape_plan_reference (shape_plan);
+  cache->get_stats (hits, misses, size);
 }
 
 
@@ -116,6 +116,16 @@ hb_shape_plan_execute (hb_shape_plan_t    *shape_plan,
 HB_EXTERN const char *
 hb_shape_plan_get_shaper (hb_shape_plan_t *shape_plan);
 
+HB_EXTERN void
+hb_face_set_shape_plan_cache_capacity (hb_face_t    *face,
+				       unsigned int  capacity);
+
+HB_EXTERN void
+hb_face_get_shape_plan_cache_stats (hb_face_t    *face,
+				    unsigned int *hits,
+				    unsigned int *misses,
+				    unsigned int *size);
+
 
 HB_END_DECLS
 
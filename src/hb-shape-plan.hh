@@ -30,6 +30,8 @@
 #include "hb.hh"
 #include "hb-shaper.hh"
 #include "hb-ot-shape.hh"
+#include "hb-map.hh"
+#include "hb-mutex.hh"
 
 
 struct hb_shape_plan_key_t
@@ -60,6 +62,8 @@ struct hb_shape_plan_key_t
   HB_INTERNAL bool user_features_match (const hb_shape_plan_key_t *other);
 
   HB_INTERNAL bool equal (const hb_shape_plan_key_t *other);
+
+  HB_INTERNAL uint32_t hash () const;
 };
 
 struct hb_shape_plan_t
@@ -74,4 +78,100 @@ struct hb_shape_plan_t
 };
 
 
+#ifndef HB_SHAPE_PLAN_CACHE_CAPACITY
+#define HB_SHAPE_PLAN_CACHE_CAPACITY 256
+#endif
+
+/* A bounded cache of shape plans, attached to a face.
+ *
+ * Plans live in an open-addressed table keyed by the hash of their key.
+ * Lookups probe the table without taking the lock and stamp the entry
+ * they hit.  Writers, serialized on the mutex, add and remove entries in
+ * place; the table is only replaced when it grows, which happens a
+ * logarithmic number of times.  When the cache is full, the entry with
+ * the oldest stamp among a few sampled from a rotating hand is evicted.
+ *
+ * The cache holds a reference to each plan, and hands out new ones.  The
+ * references of evicted plans, and superseded tables, are retired, and
+ * released by epochs: lookups register with the counter of the current
+ * epoch's parity.  What was retired during an epoch is released once the
+ * epoch has advanced and the lookups registered in it have left.  The
+ * epoch advances as soon as the previous one drained, so retired memory
+ * never waits on more than the lookups already in flight; whichever of
+ * a writer or the last such lookup notices first releases it. */
+struct hb_shape_plan_cache_t
+{
+  struct entry_t
+  {
+    hb_atomic_t<hb_shape_plan_t *> shape_plan; /* nullptr for empty slots. */
+    hb_atomic_t<unsigned> hash;
+    hb_atomic_t<unsigned> stamp; /* Last use; higher is more recent. */
+  };
+
+  struct table_t
+  {
+    unsigned mask;
+    entry_t entries[1]; /* Actually mask + 1. */
+  };
+
+  /* Unpublished, but possibly still seen by a lookup in flight. */
+  struct retired_t
+  {
+    bool is_empty () const { return !tables.length && !plans.length; }
+    void release ();
+    void fini () { release (); tables.fini (); plans.fini (); }
+
+    hb_vector_t<table_t *> tables;
+    hb_vector_t<hb_shape_plan_t *> plans;
+  };
+
+  HB_INTERNAL static hb_shape_plan_cache_t *create ();
+  HB_INTERNAL static void destroy (hb_shape_plan_cache_t *cache);
+
+  ~hb_shape_plan_cache_t () { clear (); }
+
+  /* Returns a new reference to the cached plan for key, or nullptr.
+   * Lock-free, unless it is the last lookup of an epoch with retired
+   * memory to release. */
+  HB_INTERNAL hb_shape_plan_t *lookup (hb_shape_plan_key_t *key, uint32_t hash);
+  /* Takes over shape_plan; returns a new reference to it, or to an equal
+   * plan that another thread inserted first. */
+  HB_INTERNAL hb_shape_plan_t *insert (hb_shape_plan_t *shape_plan, uint32_t hash);
+
+  HB_INTERNAL void set_capacity (unsigned capacity_);
+  HB_INTERNAL void get_stats (unsigned *hits_, unsigned *misses_, unsigned *size_);
+  HB_INTERNAL unsigned get_memory_usage ();
+  /* Drops all plans; ones still referenced elsewhere stay alive.  Must not
+   * run concurrently with any other call. */
+  HB_INTERNAL void trim () { clear (); }
+
+  private:
+
+  static entry_t *find (table_t *table, hb_shape_plan_key_t *key, uint32_t hash,
+			hb_shape_plan_t **shape_plan);
+  static unsigned get_table_size (const table_t *table)
+  { return sizeof (table_t) + table->mask * sizeof (entry_t); }
+  static table_t *create_table (unsigned size);
+  static void put (table_t *table, hb_shape_plan_t *shape_plan, unsigned hash, unsigned stamp);
+  bool grow ();
+  bool remove (unsigned i);
+  bool evict ();
+  void reclaim ();
+  void clear ();
+
+  hb_mutex_t lock; /* Serializes writers. */
+  hb_atomic_t<table_t *> table;
+  unsigned count = 0; /* Plans in table. */
+  unsigned hand = 0; /* Where the next eviction starts looking. */
+  unsigned capacity = HB_SHAPE_PLAN_CACHE_CAPACITY;
+  hb_atomic_t<unsigned> epoch;
+  hb_atomic_t<int> readers[2]; /* Lookups in flight, by epoch parity. */
+  hb_atomic_t<int> reclaimable; /* Whether anything is retired. */
+  retired_t retiring; /* Retired during the current epoch. */
+  retired_t draining; /* Retired during the previous epoch. */
+  hb_atomic_t<unsigned> hits;
+  hb_atomic_t<unsigned> misses;
+};
+
+
 #endif /* HB_SHAPE_PLAN_HH */
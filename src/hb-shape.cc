@@ -30,6 +30,7 @@
 
 #include "hb-shaper.hh"
 #include "hb-shape-plan.hh"
+#include "hb-shape-cache.hh"
 #include "hb-buffer.hh"
 #include "hb-font.hh"
 #include "hb-machinery.hh"
@@ -119,6 +120,9 @@ hb_shape_list_shapers ()
  * shapers will be used in the given order, otherwise the default shapers list
  * will be used.
  *
+ * If a shape cache was enabled on @font using hb_font_set_shape_cache(),
+ * and @shaper_list is `NULL`, results may be served from the cache.
+ *
  * Return value: false if all shapers failed, true otherwise
  *
  * Since: 0.9.2
@@ -133,6 +137,16 @@ hb_shape_full (hb_font_t          *font,
   if (unlikely (!buffer->len))
     return true;
 
+  hb_shape_cache_t *cache = shaper_list ? nullptr : font->shape_cache;
+  hb_shape_cache_t::key_t cache_key;
+  if (cache)
+  {
+    if (!hb_shape_cache_t::make_key (buffer, features, num_features, cache_key))
+      cache = nullptr;
+    else if (cache->lookup (font, cache_key, buffer))
+      return true;
+  }
+
   buffer->enter ();
 
   hb_buffer_t *text_buffer = nullptr;
@@ -154,6 +168,9 @@ hb_shape_full (hb_font_t          *font,
 
   hb_shape_plan_destroy (shape_plan);
 
+  if (cache && res && buffer->successful && !buffer->shaping_failed)
+    cache->insert (font, cache_key, buffer);
+
   if (text_buffer)
   {
     if (res && buffer->successful && !buffer->shaping_failed
@@ -172,6 +189,512 @@ hb_shape_full (hb_font_t          *font,
   return res;
 }
 
+/* Random alternates depend on the position in the whole buffer, so
+ * shaping parts of it separately gives different results. */
+static bool
+_hb_shape_features_use_random (const hb_feature_t *features,
+			       unsigned int        num_features)
+{
+  for (unsigned i = 0; i < num_features; i++)
+    if (features[i].tag == HB_TAG ('r','a','n','d'))
+      return true;
+  return false;
+}
+
+/* Parallel shaping.
+ *
+ * The text is split into chunks after spaces, each chunk is shaped
+ * separately (with its neighbours as context), and the results are
+ * concatenated.  Every seam where either side came out unsafe-to-concat
+ * has its two chunks merged and reshaped, until no such seams remain.
+ * As such the result is the same as shaping the whole buffer at once. */
+
+#define HB_SHAPE_PARALLEL_CHUNK_LENGTH 1024
+
+struct hb_shape_parallel_t
+{
+  hb_font_t *font;
+  hb_buffer_t *buffer;
+  const hb_feature_t *features;
+  unsigned int num_features;
+
+  hb_vector_t<unsigned> starts; /* Chunk boundaries in the input; one more than chunks. */
+  hb_vector_t<hb_buffer_t *> chunks; /* Shaped chunks, in logical order. */
+  hb_vector_t<unsigned> pending; /* Chunks to (re)shape. */
+
+  ~hb_shape_parallel_t ()
+  {
+    for (hb_buffer_t *chunk : chunks)
+      hb_buffer_destroy (chunk);
+  }
+
+  bool eligible () const
+  {
+    if (buffer->content_type != HB_BUFFER_CONTENT_TYPE_UNICODE ||
+	buffer->len < 2 * HB_SHAPE_PARALLEL_CHUNK_LENGTH ||
+	!HB_BUFFER_CLUSTER_LEVEL_IS_MONOTONE (buffer->cluster_level) ||
+	(buffer->flags & HB_BUFFER_FLAG_VERIFY)
+#ifndef HB_NO_BUFFER_MESSAGE
+	|| buffer->message_func
+#endif
+       )
+      return false;
+
+    return !_hb_shape_features_use_random (features, num_features);
+  }
+
+  bool is_split_point (unsigned i) const
+  {
+    const hb_glyph_info_t *info = buffer->info;
+    if (info[i - 1].cluster == info[i].cluster)
+      return false;
+
+    hb_unicode_funcs_t *unicode = buffer->unicode;
+    if (unicode->general_category (info[i - 1].codepoint) != HB_UNICODE_GENERAL_CATEGORY_SPACE_SEPARATOR)
+      return false;
+    switch ((unsigned) unicode->general_category (info[i].codepoint))
+    {
+      case HB_UNICODE_GENERAL_CATEGORY_SPACE_SEPARATOR:
+      case HB_UNICODE_GENERAL_CATEGORY_FORMAT:
+      case HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK:
+      case HB_UNICODE_GENERAL_CATEGORY_SPACING_MARK:
+      case HB_UNICODE_GENERAL_CATEGORY_ENCLOSING_MARK:
+	return false;
+      default:
+	return true;
+    }
+  }
+
+  void split ()
+  {
+    unsigned len = buffer->len;
+    starts.push (0);
+    unsigned i = HB_SHAPE_PARALLEL_CHUNK_LENGTH;
+    while (i + HB_SHAPE_PARALLEL_CHUNK_LENGTH <= len)
+    {
+      if (!is_split_point (i))
+      {
+	i++;
+	continue;
+      }
+      starts.push (i);
+      i += HB_SHAPE_PARALLEL_CHUNK_LENGTH;
+    }
+    starts.push (len);
+  }
+
+  hb_buffer_t *create_chunk (unsigned start, unsigned end) const
+  {
+    hb_buffer_t *chunk = hb_buffer_create_similar (buffer);
+    unsigned flags = buffer->flags | HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT;
+    if (start)
+      flags &= ~HB_BUFFER_FLAG_BOT;
+    if (end < buffer->len)
+      flags &= ~HB_BUFFER_FLAG_EOT;
+    hb_buffer_set_flags (chunk, (hb_buffer_flags_t) flags);
+    hb_buffer_set_segment_properties (chunk, &buffer->props);
+    chunk->random_state = buffer->random_state;
+    hb_buffer_append (chunk, buffer, start, end);
+    return chunk;
+  }
+
+  static void shape_task (void *task_data, unsigned int index)
+  {
+    hb_shape_parallel_t *c = (hb_shape_parallel_t *) task_data;
+    hb_buffer_t *chunk = c->chunks.arrayZ[c->pending.arrayZ[index]];
+    hb_shape_full (c->font, chunk, c->features, c->num_features, nullptr);
+  }
+
+  bool shape_pending (hb_executor_func_t executor, void *executor_data)
+  {
+    for (unsigned i : pending)
+    {
+      hb_buffer_destroy (chunks.arrayZ[i]);
+      chunks.arrayZ[i] = create_chunk (starts.arrayZ[i], starts.arrayZ[i + 1]);
+      if (unlikely (!chunks.arrayZ[i]->successful))
+	return false;
+    }
+
+    if (executor && pending.length > 1)
+      executor (shape_task, this, pending.length, executor_data);
+    else
+      for (unsigned i = 0; i < pending.length; i++)
+	shape_task (this, i);
+
+    bool backward = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+    for (unsigned i : pending)
+    {
+      hb_buffer_t *chunk = chunks.arrayZ[i];
+      if (unlikely (!chunk->successful || chunk->shaping_failed ||
+		    chunk->content_type != HB_BUFFER_CONTENT_TYPE_GLYPHS))
+	return false;
+      if (backward)
+	hb_buffer_reverse (chunk);
+    }
+    return true;
+  }
+
+  bool seam_is_safe (unsigned i) const
+  {
+    const hb_buffer_t *before = chunks.arrayZ[i - 1];
+    const hb_buffer_t *after = chunks.arrayZ[i];
+    if (!before->len || !after->len)
+      return false;
+    return !((before->info[before->len - 1].mask | after->info[0].mask) & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT);
+  }
+
+  /* Merges chunks across unsafe seams; returns whether there were any. */
+  bool merge_unsafe_seams ()
+  {
+    pending.resize (0);
+    unsigned count = chunks.length;
+    unsigned j = 0;
+    for (unsigned i = 0; i < count; j++)
+    {
+      unsigned end = i + 1;
+      while (end < count && !seam_is_safe (end))
+	end++;
+
+      starts.arrayZ[j] = starts.arrayZ[i];
+      if (end - i == 1)
+      {
+	chunks.arrayZ[j] = chunks.arrayZ[i];
+	i = end;
+	continue;
+      }
+
+      for (; i < end; i++)
+      {
+	hb_buffer_destroy (chunks.arrayZ[i]);
+	chunks.arrayZ[i] = nullptr;
+      }
+      chunks.arrayZ[j] = nullptr;
+      pending.push (j);
+    }
+    starts.arrayZ[j] = starts.arrayZ[count];
+    starts.resize (j + 1);
+    chunks.resize (j);
+    return pending.length;
+  }
+
+  bool shape (hb_executor_func_t executor, void *executor_data)
+  {
+    split ();
+    unsigned count = starts.length - 1;
+    if (unlikely (starts.in_error () || count < 2 ||
+		  !chunks.resize (count) ||
+		  !pending.alloc (count)))
+      return false;
+    for (unsigned i = 0; i < count; i++)
+      pending.push (i);
+
+    do
+    {
+      if (!shape_pending (executor, executor_data))
+	return false;
+    }
+    while (chunks.length > 1 && merge_unsafe_seams ());
+
+    unsigned total = 0;
+    for (const hb_buffer_t *chunk : chunks)
+      total += chunk->len;
+    if (unlikely (!buffer->ensure (total)))
+      return false;
+
+    hb_glyph_info_t *info = buffer->info;
+    hb_glyph_position_t *pos = buffer->pos;
+    for (const hb_buffer_t *chunk : chunks)
+    {
+      hb_memcpy (info, chunk->info, chunk->len * sizeof (info[0]));
+      hb_memcpy (pos, chunk->pos, chunk->len * sizeof (pos[0]));
+      info += chunk->len;
+      pos += chunk->len;
+    }
+    buffer->len = total;
+    buffer->have_output = false;
+    buffer->have_positions = true;
+    buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
+
+    if (HB_DIRECTION_IS_BACKWARD (buffer->props.direction))
+      buffer->reverse ();
+
+    if (!(buffer->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT))
+      for (unsigned i = 0; i < total; i++)
+	buffer->info[i].mask &= ~HB_GLYPH_FLAG_UNSAFE_TO_CONCAT;
+
+    return true;
+  }
+};
+
+/**
+ * hb_shape_parallel:
+ * @font: an #hb_font_t to use for shaping
+ * @buffer: an #hb_buffer_t to shape
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @executor: (scope call) (nullable): an #hb_executor_func_t to run the
+ *    shaping tasks, or `NULL` to run them on the calling thread
+ * @executor_data: user data to pass to @executor
+ *
+ * Shapes @buffer like hb_shape() does, splitting the work across
+ * multiple tasks that are handed to @executor, which would typically
+ * run them on a thread pool.
+ *
+ * The text is split into chunks of about a thousand characters at
+ * spaces, and each chunk is shaped separately, with the neighboring
+ * text as context.  Chunks are then checked against each other using
+ * the #HB_GLYPH_FLAG_UNSAFE_TO_CONCAT glyph flag, and wherever the two
+ * sides of a split do not join cleanly, the chunks around it are merged
+ * and shaped again.  The result is identical to that of hb_shape().
+ *
+ * Buffers that are too short to split, or that use random alternates,
+ * buffer verification, a message callback, or non-monotone cluster
+ * levels are shaped on the calling thread with hb_shape_full().
+ *
+ * Return value: false if shaping failed, true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_parallel (hb_font_t          *font,
+		   hb_buffer_t        *buffer,
+		   const hb_feature_t *features,
+		   unsigned int        num_features,
+		   hb_executor_func_t  executor,
+		   void               *executor_data)
+{
+  hb_shape_parallel_t c = {font, buffer, features, num_features};
+
+  if (c.eligible () && c.shape (executor, executor_data))
+    return true;
+
+  return hb_shape_full (font, buffer, features, num_features, nullptr);
+}
+
+/* Incremental reshaping. */
+
+struct hb_shape_incremental_t
+{
+  hb_font_t *font;
+  hb_buffer_t *buffer;
+  const hb_feature_t *features;
+  unsigned int num_features;
+  const hb_buffer_t *previous;
+  bool backward;
+
+  /* Glyphs of previous, in logical order. */
+  const hb_glyph_info_t &prev_info (unsigned i) const
+  { return previous->info[backward ? previous->len - 1 - i : i]; }
+  const hb_glyph_position_t &prev_pos (unsigned i) const
+  { return previous->pos[backward ? previous->len - 1 - i : i]; }
+
+  /* Whether previous can be split before glyph i, 0 < i < len. */
+  bool is_boundary (unsigned i) const
+  {
+    const hb_glyph_info_t &info = prev_info (i);
+    return info.cluster != prev_info (i - 1).cluster &&
+	   !(info.mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT);
+  }
+
+  /* First character of buffer with cluster not less than cluster. */
+  unsigned text_index (unsigned cluster) const
+  {
+    const hb_glyph_info_t *info = buffer->info;
+    unsigned lo = 0, hi = buffer->len;
+    while (lo < hi)
+    {
+      unsigned mid = lo + (hi - lo) / 2;
+      if (info[mid].cluster < cluster)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+    return lo;
+  }
+
+  hb_buffer_t *shape_region (unsigned start, unsigned end) const
+  {
+    hb_buffer_t *region = hb_buffer_create_similar (buffer);
+    unsigned flags = buffer->flags;
+    if (start)
+      flags &= ~HB_BUFFER_FLAG_BOT;
+    if (end < buffer->len)
+      flags &= ~HB_BUFFER_FLAG_EOT;
+    hb_buffer_set_flags (region, (hb_buffer_flags_t) flags);
+    hb_buffer_set_segment_properties (region, &buffer->props);
+    region->random_state = buffer->random_state;
+    hb_buffer_append (region, buffer, start, end);
+
+    hb_shape_full (font, region, features, num_features, nullptr);
+    if (unlikely (!region->successful || region->shaping_failed ||
+		  region->content_type != HB_BUFFER_CONTENT_TYPE_GLYPHS))
+    {
+      hb_buffer_destroy (region);
+      return nullptr;
+    }
+    if (backward)
+      hb_buffer_reverse (region);
+    return region;
+  }
+
+  bool shape (unsigned start, unsigned old_end, unsigned new_end)
+  {
+    unsigned count = previous->len;
+    int delta = (int) new_end - (int) old_end;
+
+    /* Smallest region of previous, bounded by clean cluster boundaries,
+     * that covers the edit. */
+    unsigned a = 0;
+    while (a < count && prev_info (a).cluster < start)
+      a++;
+    if (a && (a == count || prev_info (a).cluster > start))
+      a--; /* Edit starts inside the previous cluster. */
+    while (a && !is_boundary (a))
+      a--;
+    unsigned b = a;
+    while (b < count && prev_info (b).cluster < old_end)
+      b++;
+    while (b < count && (!b || !is_boundary (b)))
+      b++;
+
+    hb_buffer_t *region;
+    while (true)
+    {
+      unsigned text_start = a ? text_index (prev_info (a).cluster) : 0;
+      unsigned text_end = b < count ? text_index (prev_info (b).cluster + delta) : buffer->len;
+      if (unlikely (text_start > text_end))
+	return false;
+
+      region = shape_region (text_start, text_end);
+      if (unlikely (!region))
+	return false;
+
+      /* The new glyphs must not interact with the ones kept around them. */
+      bool start_ok = !a || (region->len && !(region->info[0].mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT));
+      bool end_ok = b == count || (region->len && !(region->info[region->len - 1].mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT));
+      if (start_ok && end_ok)
+	break;
+
+      hb_buffer_destroy (region);
+      if (!start_ok)
+	do a--; while (a && !is_boundary (a));
+      if (!end_ok)
+	do b++; while (b < count && !is_boundary (b));
+    }
+
+    unsigned total = a + region->len + (count - b);
+    if (unlikely (!buffer->ensure (total)))
+    {
+      hb_buffer_destroy (region);
+      return false;
+    }
+
+    hb_glyph_info_t *info = buffer->info;
+    hb_glyph_position_t *pos = buffer->pos;
+    for (unsigned i = 0; i < a; i++)
+    {
+      *info++ = prev_info (i);
+      *pos++ = prev_pos (i);
+    }
+    hb_memcpy (info, region->info, region->len * sizeof (info[0]));
+    hb_memcpy (pos, region->pos, region->len * sizeof (pos[0]));
+    info += region->len;
+    pos += region->len;
+    for (unsigned i = b; i < count; i++)
+    {
+      *info = prev_info (i);
+      info->cluster += delta;
+      info++;
+      *pos++ = prev_pos (i);
+    }
+    hb_buffer_destroy (region);
+
+    buffer->len = total;
+    buffer->have_output = false;
+    buffer->have_positions = true;
+    buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
+    if (backward)
+      buffer->reverse ();
+
+    return true;
+  }
+};
+
+/**
+ * hb_shape_incremental:
+ * @font: an #hb_font_t to use for shaping
+ * @buffer: an #hb_buffer_t to shape
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @previous: the result of shaping the text of @buffer before the edit
+ * @start: cluster value where the edit starts
+ * @old_end: cluster value where the replaced text ended, before the edit
+ * @new_end: cluster value where the replacement text ends, after the edit
+ *
+ * Shapes @buffer like hb_shape() does, reusing the glyphs of @previous
+ * for the parts of the text that were not affected by an edit.  This
+ * makes reshaping a paragraph after each keystroke in a text editor
+ * cost in proportion to the size of the edit, not of the paragraph.
+ *
+ * @previous must hold the shaping output, using the same font, features,
+ * segment properties, and buffer flags, of the text before the edit.
+ * The edit replaced the characters with cluster values from @start to
+ * @old_end in that text with ones with cluster values from @start to
+ * @new_end in @buffer.  Cluster values after the edit are shifted by
+ * the difference.  Cluster values must be increasing in both texts, as
+ * is the case with the buffer add functions.
+ *
+ * The region of @previous around the edit, bounded on both sides by
+ * glyphs that do not have the #HB_GLYPH_FLAG_UNSAFE_TO_CONCAT flag, is
+ * shaped again, and its new glyphs spliced in between the kept ones.
+ * If the new glyphs are themselves unsafe to concatenate at the edges,
+ * the region is grown until they are not.  The result is identical to
+ * that of hb_shape().
+ *
+ * This needs the unsafe-to-concat glyph flags, so @buffer must have the
+ * #HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT flag set, and @previous must
+ * have been shaped with it too.  Otherwise, or if @previous does not
+ * have matching direction, or random alternates are requested, @buffer
+ * is shaped with hb_shape_full() from scratch.
+ *
+ * Return value: false if shaping failed, true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_incremental (hb_font_t          *font,
+		      hb_buffer_t        *buffer,
+		      const hb_feature_t *features,
+		      unsigned int        num_features,
+		      const hb_buffer_t  *previous,
+		      unsigned int        start,
+		      unsigned int        old_end,
+		      unsigned int        new_end)
+{
+  if (buffer->len &&
+      buffer->content_type == HB_BUFFER_CONTENT_TYPE_UNICODE &&
+      (buffer->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT) &&
+      !(buffer->flags & HB_BUFFER_FLAG_VERIFY) &&
+      HB_BUFFER_CLUSTER_LEVEL_IS_MONOTONE (buffer->cluster_level) &&
+      previous->len &&
+      previous->content_type == HB_BUFFER_CONTENT_TYPE_GLYPHS &&
+      previous->have_positions &&
+      (previous->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT) &&
+      previous->props.direction == buffer->props.direction &&
+      start <= old_end && start <= new_end &&
+      !_hb_shape_features_use_random (features, num_features))
+  {
+    hb_shape_incremental_t c = {font, buffer, features, num_features, previous,
+				HB_DIRECTION_IS_BACKWARD (buffer->props.direction)};
+    if (c.shape (start, old_end, new_end))
+      return true;
+  }
+
+  return hb_shape_full (font, buffer, features, num_features, nullptr);
+}
+
 /**
  * hb_shape:
  * @font: an #hb_font_t to use for shaping
@@ -198,6 +721,89 @@ hb_shape (hb_font_t           *font,
 }
 
 
+/**
+ * hb_font_set_shape_cache:
+ * @font: #hb_font_t to work upon
+ * @max_memory: maximum number of bytes to spend on cached results
+ *
+ * Enables caching of shaping results on @font.  When enabled,
+ * hb_shape() and hb_shape_full() remember the glyphs and positions
+ * produced for short buffers, and when the same text is shaped again
+ * with the same context, segment properties, buffer flags, and
+ * features, copy the remembered result into the buffer instead of
+ * shaping it again.
+ *
+ * Only buffers of up to 64 characters, with strictly increasing
+ * cluster values and global features only, are cached.  Buffers that
+ * request verification or have a message callback set are never
+ * cached.  The pre- and post-context of the buffer are part of the
+ * cache key, so results that would be affected by their surroundings
+ * are not reused in a different context.
+ *
+ * Changing any property of @font, or of any of its parents, discards
+ * all cached results.  Least-recently-used results are discarded when
+ * the cache would otherwise grow beyond @max_memory bytes.
+ *
+ * Passing zero for @max_memory disables the cache and releases its
+ * memory.  The cache is safe to use from multiple threads shaping with
+ * @font concurrently, but this function itself is not.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_set_shape_cache (hb_font_t    *font,
+			 unsigned int  max_memory)
+{
+  if (hb_object_is_immutable (font))
+    return;
+
+  if (!max_memory)
+  {
+    hb_shape_cache_t::destroy (font->shape_cache);
+    font->shape_cache = nullptr;
+    return;
+  }
+
+  if (font->shape_cache)
+  {
+    font->shape_cache->set_max_memory (max_memory);
+    return;
+  }
+
+  font->shape_cache = hb_shape_cache_t::create (max_memory);
+}
+
+/**
+ * hb_font_get_shape_cache_stats:
+ * @font: #hb_font_t to work upon
+ * @hits: (out) (optional): number of buffers served from the cache
+ * @misses: (out) (optional): number of cacheable buffers not found in the cache
+ * @memory: (out) (optional): number of bytes currently used by the cache
+ *
+ * Fetches statistics about the shape cache of @font, as enabled by
+ * hb_font_set_shape_cache().  All values are zero if the cache is
+ * not enabled.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_get_shape_cache_stats (hb_font_t    *font,
+			       unsigned int *hits,
+			       unsigned int *misses,
+			       unsigned int *memory)
+{
+  if (!font->shape_cache)
+  {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (memory) *memory = 0;
+    return;
+  }
+
+  font->shape_cache->get_stats (hits, misses, memory);
+}
+
+
 #ifdef HB_EXPERIMENTAL_API
 
 static float
@@ -53,6 +53,34 @@ hb_shape_full (hb_font_t          *font,
 	       unsigned int        num_features,
 	       const char * const *shaper_list);
 
+HB_EXTERN hb_bool_t
+hb_shape_parallel (hb_font_t          *font,
+		   hb_buffer_t        *buffer,
+		   const hb_feature_t *features,
+		   unsigned int        num_features,
+		   hb_executor_func_t  executor,
+		   void               *executor_data);
+
+HB_EXTERN hb_bool_t
+hb_shape_incremental (hb_font_t          *font,
+		      hb_buffer_t        *buffer,
+		      const hb_feature_t *features,
+		      unsigned int        num_features,
+		      const hb_buffer_t  *previous,
+		      unsigned int        start,
+		      unsigned int        old_end,
+		      unsigned int        new_end);
+
+HB_EXTERN void
+hb_font_set_shape_cache (hb_font_t    *font,
+			 unsigned int  max_memory);
+
+HB_EXTERN void
+hb_font_get_shape_cache_stats (hb_font_t    *font,
+			       unsigned int *hits,
+			       unsigned int *misses,
+			       unsigned int *memory);
+
 #ifdef HB_EXPERIMENTAL_API
 HB_EXTERN hb_bool_t
 hb_shape_justify (hb_font_t          *font,
@@ -0,0 +1,116 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Google Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_SHARDED_POOL_HH
+#define HB_SHARDED_POOL_HH
+
+#include "hb.hh"
+
+#include "hb-atomic.hh"
+
+
+#ifndef HB_SHARDED_POOL_SLOTS
+#define HB_SHARDED_POOL_SLOTS 8
+#endif
+
+/* A lock-free pool of reusable objects, like caches or scratch buffers,
+ * shared by all threads using a font or face.
+ *
+ * With a single slot, all but one of the threads concurrently using the
+ * object create a fresh, cold, one, only to destroy it when done.  With
+ * several slots, concurrent users each find an object to reuse.  Each
+ * thread starts probing at a slot derived from its stack address, so
+ * that it tends to get back the object it last returned, which is warm
+ * for the text it is working on.
+ *
+ * An object is owned by whoever took it out of a slot; slots never
+ * hold an object that is in use.
+ */
+template <typename T, unsigned N = HB_SHARDED_POOL_SLOTS>
+struct hb_sharded_pool_t
+{
+  static_assert (N && !(N & (N - 1)), "");
+
+  /* Returns an object from the pool, or create() if there is none. */
+  template <typename Create>
+  T *acquire (Create create) const
+  {
+    unsigned start = get_start ();
+    for (unsigned i = 0; i < N; i++)
+    {
+      auto &slot = slots[(start + i) & (N - 1)];
+      T *obj = slot.get_acquire ();
+      if (obj && slot.cmpexch (obj, nullptr))
+	return obj;
+    }
+    return create ();
+  }
+
+  /* Puts obj back into the pool, or destroy()s it if the pool is full. */
+  template <typename Destroy>
+  void release (T *obj, Destroy destroy) const
+  {
+    if (!obj)
+      return;
+    unsigned start = get_start ();
+    for (unsigned i = 0; i < N; i++)
+    {
+      auto &slot = slots[(start + i) & (N - 1)];
+      if (!slot.get_relaxed () && slot.cmpexch (nullptr, obj))
+	return;
+    }
+    destroy (obj);
+  }
+
+  /* Destroys all pooled objects.  Objects currently taken out are not
+   * affected. */
+  template <typename Destroy>
+  void clear (Destroy destroy) const
+  {
+    for (auto &slot : slots)
+    {
+      T *obj = slot.get_acquire ();
+      if (obj && slot.cmpexch (obj, nullptr))
+	destroy (obj);
+    }
+  }
+
+  private:
+
+  /* Threads have their stacks far apart, while a thread's own stack
+   * depth varies little between calls into us. */
+  static unsigned get_start ()
+  {
+    int local;
+    uint32_t h = (uint32_t) ((uintptr_t) &local >> 16);
+    return (h * 2654435761u) >> 24;
+  }
+
+  mutable hb_atomic_t<T *> slots[N];
+};
+
+
+#endif /* HB_SHARDED_POOL_HH */
@@ -89,7 +89,7 @@
  {
    if (&var_store == &Null (OT::ItemVariationStore)) return;
    unsigned subtable_count = var_store.get_sub_table_count ();
-   auto *store_cache = var_store.create_cache ();
+   auto *store_cache = var_store.create_cache (normalized_coords.arrayZ, normalized_coords.length);
  
    unsigned new_major = 0, new_minor = 0;
    unsigned last_major = (variation_indices.get_min ()) >> 16;
@@ -245,12 +245,12 @@ update_instance_metrics_map_from_cff2 (hb_subset_plan_t *plan)
   OT::hmtx_accelerator_t _hmtx (plan->source);
   OT::ItemVariationStore::cache_t *hvar_store_cache = nullptr;
   if (_hmtx.has_data () && _hmtx.var_table.get_length ())
-    hvar_store_cache = _hmtx.var_table->get_var_store ().create_cache ();
+    hvar_store_cache = _hmtx.var_table->get_var_store ().create_cache (font->coords, font->num_coords);
 
   OT::vmtx_accelerator_t _vmtx (plan->source);
   OT::ItemVariationStore::cache_t *vvar_store_cache = nullptr;
   if (_vmtx.has_data () && _vmtx.var_table.get_length ())
-    vvar_store_cache = _vmtx.var_table->get_var_store ().create_cache ();
+    vvar_store_cache = _vmtx.var_table->get_var_store ().create_cache (font->coords, font->num_coords);
 
   for (auto p : *plan->glyph_map)
   {
@@ -106,5 +106,21 @@ main (int argc, char **argv)
   assert (hb_hash (set1) == hb_hash (hb::shared_ptr<hb_set_t> {hb_set_reference (&set1)}));
   assert (hb_hash (set1) == hb_hash (hb::unique_ptr<hb_set_t> {hb_set_reference (&set1)}));
 
+  /* Test vectors from the SipHash reference implementation. */
+  {
+    HB_UNUSED const uint64_t k0 = 0x0706050403020100ULL, k1 = 0x0f0e0d0c0b0a0908ULL;
+    HB_UNUSED const unsigned char msg[15] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+    assert (hb_siphash24 (msg, 0, k0, k1) == 0x726fdb47dd0e0e31ULL);
+    assert (hb_siphash24 (msg, 1, k0, k1) == 0x74f839c593dc67fdULL);
+    assert (hb_siphash24 (msg, 7, k0, k1) == 0xab0200f58b01d137ULL);
+    assert (hb_siphash24 (msg, 8, k0, k1) == 0x93f5f5799a932462ULL);
+    assert (hb_siphash24 (msg, 15, k0, k1) == 0xa129ca6149be45e5ULL);
+
+    /* Words are read the same from unaligned data. */
+    unsigned char unaligned[16];
+    hb_memcpy (unaligned + 1, msg, sizeof (msg));
+    assert (hb_siphash24 (unaligned + 1, 15, k0, k1) == 0xa129ca6149be45e5ULL);
+  }
+
   return 0;
 }
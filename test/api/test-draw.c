@@ -333,6 +333,50 @@ test_hb_draw_cff2 (void)
   hb_font_destroy (font);
 }
 
+static void
+test_hb_draw_cff_repeated (void)
+{
+  /* CFF charstrings are flattened on first use; drawing again must
+   * produce the same outlines. */
+  const char *font_files[] = {
+    "fonts/SourceSansPro-Regular.otf",
+    "fonts/AdobeVFPrototype.abc.otf",
+    "fonts/cmunrm.otf",
+  };
+  char str[8192], str2[8192];
+  draw_data_t draw_data = {
+    .str = str,
+    .size = sizeof (str)
+  };
+  draw_data_t draw_data2 = {
+    .str = str2,
+    .size = sizeof (str2)
+  };
+  for (unsigned i = 0; i < G_N_ELEMENTS (font_files); i++)
+  {
+    hb_face_t *face = hb_test_open_font_file (font_files[i]);
+    hb_font_t *font = hb_font_create (face);
+    unsigned glyph_count = hb_face_get_glyph_count (face);
+    hb_face_destroy (face);
+
+    for (unsigned gid = 0; gid < glyph_count; gid++)
+    {
+      hb_glyph_extents_t extents, extents2;
+      hb_bool_t ret = hb_font_get_glyph_extents (font, gid, &extents);
+      draw_data.consumed = 0;
+      hb_font_draw_glyph (font, gid, funcs, &draw_data);
+
+      g_assert_cmpint (ret, ==, hb_font_get_glyph_extents (font, gid, &extents2));
+      g_assert_cmpmem (&extents, sizeof (extents), &extents2, sizeof (extents2));
+      draw_data2.consumed = 0;
+      hb_font_draw_glyph (font, gid, funcs, &draw_data2);
+      g_assert_cmpmem (str, draw_data.consumed, str2, draw_data2.consumed);
+    }
+
+    hb_font_destroy (font);
+  }
+}
+
 static void
 test_hb_draw_ttf_parser_tests (void)
 {
@@ -1065,6 +1109,103 @@ test_hb_draw_subfont_scale (void)
   }
 }
 
+static void
+test_hb_draw_outline_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype.abc.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+
+  char str[1024], str2[1024];
+  draw_data_t draw_data = {
+    .str = str,
+    .size = sizeof (str)
+  };
+  draw_data_t draw_data2 = {
+    .str = str2,
+    .size = sizeof (str2)
+  };
+  unsigned hits, misses, evictions, memory;
+
+  hb_font_set_outline_cache (font, 1 << 16);
+
+  char expected[] = "M275,442C303,442 337,435 371,417L325,454L350,366"
+		    "C357,341 370,321 403,321C428,321 443,333 448,358"
+		    "C435,432 361,487 272,487C153,487 43,393 43,236"
+		    "C43,83 129,-13 266,-13C360,-13 424,33 451,116L427,128"
+		    "C396,78 345,50 287,50C193,50 126,119 126,245C126,373 188,442 275,442Z";
+  for (unsigned i = 0; i < 2; i++)
+  {
+    draw_data.consumed = 0;
+    g_assert_true (hb_font_draw_glyph_or_fail (font, 3, funcs, &draw_data));
+    g_assert_cmpmem (str, draw_data.consumed, expected, sizeof (expected) - 1);
+  }
+  hb_font_get_outline_cache_stats (font, &hits, &misses, &evictions, &memory);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 1);
+  g_assert_cmpuint (evictions, ==, 0);
+  g_assert_cmpuint (memory, >, 0);
+
+  /* Outlines of different instances are cached side by side. */
+  hb_variation_t var;
+  var.tag = HB_TAG ('w','g','h','t');
+  char expected2[] = "M323,448C356,448 380,441 411,427L333,469L339,401"
+		     "C343,322 379,297 420,297C458,297 480,314 492,352"
+		     "C486,433 412,501 303,501C148,501 25,406 25,241"
+		     "C25,70 143,-16 279,-16C374,-16 447,22 488,103L451,137"
+		     "C423,107 390,86 344,86C262,86 209,148 209,261C209,398 271,448 323,448Z";
+  var.value = 800;
+  hb_font_set_variations (font, &var, 1);
+  draw_data.consumed = 0;
+  hb_font_draw_glyph (font, 3, funcs, &draw_data);
+  g_assert_cmpmem (str, draw_data.consumed, expected2, sizeof (expected2) - 1);
+
+  var.value = 400;
+  hb_font_set_variations (font, &var, 1);
+  draw_data.consumed = 0;
+  hb_font_draw_glyph (font, 3, funcs, &draw_data);
+  hb_font_set_outline_cache (font, 0);
+  draw_data2.consumed = 0;
+  hb_font_draw_glyph (font, 3, funcs, &draw_data2);
+  g_assert_cmpmem (str, draw_data.consumed, str2, draw_data2.consumed);
+  hb_font_get_outline_cache_stats (font, &hits, &misses, &evictions, &memory);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (memory, ==, 0);
+
+  hb_font_set_outline_cache (font, 1 << 16);
+  var.value = 800;
+  hb_font_set_variations (font, &var, 1);
+  hb_font_draw_glyph (font, 3, funcs, &draw_data);
+  var.value = 400;
+  hb_font_set_variations (font, &var, 1);
+  hb_font_draw_glyph (font, 3, funcs, &draw_data);
+  var.value = 800;
+  hb_font_set_variations (font, &var, 1);
+  draw_data.consumed = 0;
+  hb_font_draw_glyph (font, 3, funcs, &draw_data);
+  g_assert_cmpmem (str, draw_data.consumed, expected2, sizeof (expected2) - 1);
+  hb_font_get_outline_cache_stats (font, &hits, &misses, NULL, NULL);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 2);
+
+  /* Other font changes flush the cache. */
+  hb_font_set_scale (font, 2000, 2000);
+  draw_data.consumed = 0;
+  hb_font_draw_glyph (font, 3, funcs, &draw_data);
+  hb_font_get_outline_cache_stats (font, &hits, &misses, NULL, NULL);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 3);
+  g_assert_cmpuint (draw_data.consumed, >, sizeof (expected2) - 1);
+
+  /* Least-recently-used outlines are evicted to stay within budget. */
+  hb_font_set_outline_cache (font, 1);
+  hb_font_get_outline_cache_stats (font, NULL, NULL, &evictions, &memory);
+  g_assert_cmpuint (evictions, ==, 1);
+  g_assert_cmpuint (memory, ==, 0);
+
+  hb_font_destroy (font);
+}
+
 static void
 test_hb_draw_immutable (void)
 {
@@ -1181,6 +1322,7 @@ main (int argc, char **argv)
   hb_test_add (test_hb_draw_cff1);
   hb_test_add (test_hb_draw_cff1_rline);
   hb_test_add (test_hb_draw_cff2);
+  hb_test_add (test_hb_draw_cff_repeated);
   hb_test_add (test_hb_draw_ttf_parser_tests);
   hb_test_add (test_hb_draw_font_kit_glyphs_tests);
   hb_test_add (test_hb_draw_font_kit_variations_tests);
@@ -1189,6 +1331,7 @@ main (int argc, char **argv)
   hb_test_add (test_hb_draw_drawing_funcs);
   hb_test_add (test_hb_draw_synthetic_slant);
   hb_test_add (test_hb_draw_subfont_scale);
+  hb_test_add (test_hb_draw_outline_cache);
   hb_test_add (test_hb_draw_immutable);
 
   const char **font_funcs = hb_font_list_funcs ();
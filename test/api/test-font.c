@@ -26,6 +26,8 @@
 
 #include "hb-test.h"
 
+#include <hb-ot.h>
+
 /* Unit tests for hb-font.h */
 
 
@@ -672,6 +674,119 @@ test_font_properties (void)
   hb_font_destroy (subfont);
 }
 
+static void
+assert_fonts_equal (hb_font_t *font1, hb_font_t *font2)
+{
+  unsigned int glyph_count = hb_face_get_glyph_count (hb_font_get_face (font1));
+  hb_font_extents_t fextents1, fextents2;
+  hb_position_t metric1, metric2;
+  hb_buffer_t *buffer1, *buffer2;
+  hb_glyph_position_t *pos1, *pos2;
+  unsigned int len1, len2;
+
+  g_assert_true (hb_font_get_h_extents (font1, &fextents1) == hb_font_get_h_extents (font2, &fextents2));
+  g_assert_cmpint (fextents1.ascender, ==, fextents2.ascender);
+  g_assert_cmpint (fextents1.descender, ==, fextents2.descender);
+  g_assert_cmpint (fextents1.line_gap, ==, fextents2.line_gap);
+
+  for (hb_codepoint_t glyph = 0; glyph < glyph_count; glyph++)
+  {
+    hb_glyph_extents_t extents1, extents2;
+    hb_position_t x1, y1, x2, y2;
+
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font1, glyph), ==, hb_font_get_glyph_h_advance (font2, glyph));
+    g_assert_cmpint (hb_font_get_glyph_v_advance (font1, glyph), ==, hb_font_get_glyph_v_advance (font2, glyph));
+
+    g_assert_true (hb_font_get_glyph_v_origin (font1, glyph, &x1, &y1) == hb_font_get_glyph_v_origin (font2, glyph, &x2, &y2));
+    g_assert_cmpint (x1, ==, x2);
+    g_assert_cmpint (y1, ==, y2);
+
+    g_assert_true (hb_font_get_glyph_extents (font1, glyph, &extents1) == hb_font_get_glyph_extents (font2, glyph, &extents2));
+    g_assert_cmpint (extents1.x_bearing, ==, extents2.x_bearing);
+    g_assert_cmpint (extents1.y_bearing, ==, extents2.y_bearing);
+    g_assert_cmpint (extents1.width, ==, extents2.width);
+    g_assert_cmpint (extents1.height, ==, extents2.height);
+  }
+
+  g_assert_true (hb_ot_metrics_get_position (font1, HB_OT_METRICS_TAG_X_HEIGHT, &metric1) ==
+		 hb_ot_metrics_get_position (font2, HB_OT_METRICS_TAG_X_HEIGHT, &metric2));
+  g_assert_cmpint (metric1, ==, metric2);
+  g_assert_true (hb_ot_metrics_get_position (font1, HB_OT_METRICS_TAG_UNDERLINE_OFFSET, &metric1) ==
+		 hb_ot_metrics_get_position (font2, HB_OT_METRICS_TAG_UNDERLINE_OFFSET, &metric2));
+  g_assert_cmpint (metric1, ==, metric2);
+
+  buffer1 = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer1, "AVAWAVWA", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer1);
+  buffer2 = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer2, "AVAWAVWA", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer2);
+
+  hb_shape (font1, buffer1, NULL, 0);
+  hb_shape (font2, buffer2, NULL, 0);
+  pos1 = hb_buffer_get_glyph_positions (buffer1, &len1);
+  pos2 = hb_buffer_get_glyph_positions (buffer2, &len2);
+  g_assert_cmpuint (len1, ==, len2);
+  for (unsigned int i = 0; i < len1; i++)
+  {
+    g_assert_cmpint (pos1[i].x_advance, ==, pos2[i].x_advance);
+    g_assert_cmpint (pos1[i].x_offset, ==, pos2[i].x_offset);
+    g_assert_cmpint (pos1[i].y_offset, ==, pos2[i].y_offset);
+  }
+
+  hb_buffer_destroy (buffer1);
+  hb_buffer_destroy (buffer2);
+}
+
+static void
+test_font_freeze_instance (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype.WAV.gpos.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *frozen = hb_font_create (face);
+  hb_font_t *subfont;
+  hb_variation_t variation = { HB_TAG ('w','g','h','t'), 600 };
+  unsigned int memory = 0;
+
+  hb_font_set_variations (font, &variation, 1);
+  hb_font_set_variations (frozen, &variation, 1);
+
+  g_assert_true (hb_font_freeze_instance (frozen, &memory));
+  g_assert_cmpuint (memory, >, 0);
+  assert_fonts_equal (font, frozen);
+
+  /* Changing the font discards the frozen data. */
+  variation.value = 300;
+  hb_font_set_variations (font, &variation, 1);
+  hb_font_set_variations (frozen, &variation, 1);
+  assert_fonts_equal (font, frozen);
+
+  g_assert_true (hb_font_freeze_instance (frozen, NULL));
+  hb_font_set_scale (font, 2000, 3000);
+  hb_font_set_scale (frozen, 2000, 3000);
+  assert_fonts_equal (font, frozen);
+
+  /* So does changing a parent font. */
+  subfont = hb_font_create_sub_font (frozen);
+  g_assert_true (hb_font_freeze_instance (subfont, NULL));
+  variation.value = 700;
+  hb_font_set_variations (frozen, &variation, 1);
+  hb_font_destroy (font);
+  font = hb_font_create_sub_font (frozen);
+  variation.value = 300;
+  hb_font_set_variations (font, &variation, 1);
+  assert_fonts_equal (font, subfont);
+  hb_font_destroy (subfont);
+
+  hb_font_make_immutable (frozen);
+  g_assert_false (hb_font_freeze_instance (frozen, &memory));
+  g_assert_cmpuint (memory, ==, 0);
+
+  hb_font_destroy (frozen);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -689,6 +804,7 @@ main (int argc, char **argv)
 
   hb_test_add (test_font_empty);
   hb_test_add (test_font_properties);
+  hb_test_add (test_font_freeze_instance);
 
   return hb_test_run();
 }
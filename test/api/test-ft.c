@@ -109,12 +109,224 @@ test_native_ft_basic (void)
   cleanup_freetype ();
 }
 
+static void
+assert_fonts_equal (hb_font_t *font1, hb_font_t *font2)
+{
+  unsigned int glyph_count = hb_face_get_glyph_count (hb_font_get_face (font1));
+  hb_codepoint_t glyph1, glyph2;
+  hb_font_extents_t fextents1, fextents2;
+
+  g_assert_true (hb_font_get_nominal_glyph (font1, 'A', &glyph1));
+  g_assert_true (hb_font_get_nominal_glyph (font2, 'A', &glyph2));
+  g_assert_cmpuint (glyph1, ==, glyph2);
+
+  hb_font_get_h_extents (font1, &fextents1);
+  hb_font_get_h_extents (font2, &fextents2);
+  g_assert_cmpint (fextents1.ascender, ==, fextents2.ascender);
+  g_assert_cmpint (fextents1.descender, ==, fextents2.descender);
+
+  for (hb_codepoint_t glyph = 0; glyph < glyph_count; glyph++)
+  {
+    hb_glyph_extents_t extents1, extents2;
+
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font1, glyph), ==, hb_font_get_glyph_h_advance (font2, glyph));
+
+    g_assert_true (hb_font_get_glyph_extents (font1, glyph, &extents1));
+    g_assert_true (hb_font_get_glyph_extents (font2, glyph, &extents2));
+    g_assert_cmpint (extents1.x_bearing, ==, extents2.x_bearing);
+    g_assert_cmpint (extents1.y_bearing, ==, extents2.y_bearing);
+    g_assert_cmpint (extents1.width, ==, extents2.width);
+    g_assert_cmpint (extents1.height, ==, extents2.height);
+  }
+}
+
+static void
+test_native_ft_face_pool (void)
+{
+  FT_Face ft_face1, ft_face2;
+  hb_font_t *font1, *font2, *font;
+
+  init_freetype ();
+
+  ft_face1 = get_ft_face ("fonts/Cantarell.A.otf");
+  ft_face2 = get_ft_face ("fonts/Cantarell.A.otf");
+  font1 = hb_ft_font_create_referenced (ft_face1);
+  font2 = hb_ft_font_create_referenced (ft_face2);
+
+  g_assert_true (hb_ft_font_set_face_pool_size (font2, 4));
+  assert_fonts_equal (font1, font2);
+
+  /* Faces in the pool follow changes to the font. */
+  hb_font_set_scale (font1, 3000, -1500);
+  hb_font_set_scale (font2, 3000, -1500);
+  assert_fonts_equal (font1, font2);
+
+  g_assert_true (hb_ft_font_set_face_pool_size (font2, 0));
+  assert_fonts_equal (font1, font2);
+
+  /* Only works with hb-ft fonts. */
+  font = hb_font_create (hb_font_get_face (font1));
+  g_assert_false (hb_ft_font_set_face_pool_size (font, 4));
+  hb_font_destroy (font);
+
+  hb_font_destroy (font1);
+  hb_font_destroy (font2);
+
+  FT_Done_Face (ft_face1);
+  FT_Done_Face (ft_face2);
+
+  cleanup_freetype ();
+}
+
+typedef struct
+{
+  hb_font_t *font;
+  hb_codepoint_t glyph;
+  float sum;
+  hb_bool_t nested; /* Whether to query the main face on first callback. */
+  float main_sum;
+  hb_position_t main_advance;
+  hb_glyph_extents_t main_extents;
+} pool_draw_data_t;
+
+static hb_draw_funcs_t *pool_draw_funcs;
+
+static void
+pool_draw_point (void *draw_data, float x, float y)
+{
+  pool_draw_data_t *data = (pool_draw_data_t *) draw_data;
+  data->sum += x * 3 + y * 7;
+
+  if (data->nested)
+  {
+    /* The only face of the pool is busy drawing, so these calls are
+     * served by the main face. */
+    pool_draw_data_t main_data = {data->font, data->glyph, 0, FALSE, 0, 0, {0}};
+    data->nested = FALSE;
+    data->main_advance = hb_font_get_glyph_h_advance (data->font, data->glyph);
+    g_assert_true (hb_font_get_glyph_extents (data->font, data->glyph, &data->main_extents));
+    hb_font_draw_glyph (data->font, data->glyph, pool_draw_funcs, &main_data);
+    data->main_sum = main_data.sum;
+  }
+}
+
+static void
+pool_move_to (hb_draw_funcs_t *dfuncs HB_UNUSED, void *draw_data,
+	      hb_draw_state_t *st HB_UNUSED,
+	      float to_x, float to_y,
+	      void *user_data HB_UNUSED)
+{
+  pool_draw_point (draw_data, to_x, to_y);
+}
+
+static void
+pool_cubic_to (hb_draw_funcs_t *dfuncs HB_UNUSED, void *draw_data,
+	       hb_draw_state_t *st HB_UNUSED,
+	       float control1_x, float control1_y,
+	       float control2_x, float control2_y,
+	       float to_x, float to_y,
+	       void *user_data HB_UNUSED)
+{
+  pool_draw_point (draw_data, control1_x, control1_y);
+  pool_draw_point (draw_data, control2_x, control2_y);
+  pool_draw_point (draw_data, to_x, to_y);
+}
+
+static void
+check_face_pool_matches_main_face (hb_font_t *font)
+{
+  unsigned int glyph_count;
+  hb_codepoint_t glyph;
+
+  glyph_count = hb_face_get_glyph_count (hb_font_get_face (font));
+  for (glyph = 0; glyph < glyph_count; glyph++)
+  {
+    pool_draw_data_t data = {font, glyph, 0, TRUE, 0, 0, {0}};
+    hb_glyph_extents_t extents;
+
+    hb_font_draw_glyph (font, glyph, pool_draw_funcs, &data);
+    if (data.nested)
+      continue; /* Empty glyph. */
+
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, glyph), ==, data.main_advance);
+    g_assert_true (hb_font_get_glyph_extents (font, glyph, &extents));
+    g_assert_cmpint (extents.x_bearing, ==, data.main_extents.x_bearing);
+    g_assert_cmpint (extents.y_bearing, ==, data.main_extents.y_bearing);
+    g_assert_cmpint (extents.width, ==, data.main_extents.width);
+    g_assert_cmpint (extents.height, ==, data.main_extents.height);
+    g_assert_cmpfloat (data.sum, ==, data.main_sum);
+  }
+}
+
+static void
+test_native_ft_face_pool_main_face (void)
+{
+  FT_Face ft_face;
+  FT_Matrix matrix = {0x18000, 0x4000, 0, 0x10000};
+  FT_Matrix other_matrix = {0x10000, -0x6000, 0, 0xC000};
+  FT_Matrix current;
+  FT_UShort x_ppem, y_ppem;
+  hb_font_t *font;
+  /* Variable, and not. */
+  const char *paths[] = {"fonts/Cantarell.A.otf", "fonts/Qahiri-Regular.ttf"};
+  unsigned int i;
+
+  init_freetype ();
+
+  pool_draw_funcs = hb_draw_funcs_create ();
+  hb_draw_funcs_set_move_to_func (pool_draw_funcs, pool_move_to, NULL, NULL);
+  hb_draw_funcs_set_line_to_func (pool_draw_funcs, (hb_draw_line_to_func_t) pool_move_to, NULL, NULL);
+  hb_draw_funcs_set_cubic_to_func (pool_draw_funcs, pool_cubic_to, NULL, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (paths); i++)
+  {
+    /* Size and transform set directly on the FT_Face must not make results
+     * depend on whether a call gets the main face or one from the pool. */
+    ft_face = get_ft_face (paths[i]);
+    g_assert_cmpint (FT_Set_Char_Size (ft_face, 0, 10 * 64, 300, 96), ==, 0);
+    FT_Set_Transform (ft_face, &matrix, NULL);
+    x_ppem = ft_face->size->metrics.x_ppem;
+    y_ppem = ft_face->size->metrics.y_ppem;
+    font = hb_ft_font_create_referenced (ft_face);
+    g_assert_true (hb_ft_font_set_face_pool_size (font, 1));
+
+    check_face_pool_matches_main_face (font);
+
+    /* The pool copies the FT_Face set-up, and leaves the FT_Face alone. */
+    FT_Get_Transform (ft_face, &current, NULL);
+    g_assert_cmpint (current.xx, ==, matrix.xx);
+    g_assert_cmpint (current.xy, ==, matrix.xy);
+    g_assert_cmpint (current.yx, ==, matrix.yx);
+    g_assert_cmpint (current.yy, ==, matrix.yy);
+    g_assert_cmpint (ft_face->size->metrics.x_ppem, ==, x_ppem);
+    g_assert_cmpint (ft_face->size->metrics.y_ppem, ==, y_ppem);
+
+    /* Changes made to the FT_Face later reach the pool through
+     * hb_ft_font_changed(). */
+    hb_ft_font_lock_face (font);
+    FT_Set_Transform (ft_face, &other_matrix, NULL);
+    hb_ft_font_unlock_face (font);
+    hb_ft_font_changed (font);
+
+    check_face_pool_matches_main_face (font);
+
+    hb_font_destroy (font);
+    FT_Done_Face (ft_face);
+  }
+
+  hb_draw_funcs_destroy (pool_draw_funcs);
+
+  cleanup_freetype ();
+}
+
 int
 main (int argc, char **argv)
 {
   hb_test_init (&argc, &argv);
 
   hb_test_add (test_native_ft_basic);
+  hb_test_add (test_native_ft_face_pool);
+  hb_test_add (test_native_ft_face_pool_main_face);
 
   return hb_test_run ();
 }
@@ -213,6 +213,308 @@ test_ot_var_axis_on_zero_named_instance (void)
   hb_face_destroy (face);
 }
 
+static void
+test_ot_face_nominal_glyphs_repeated (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Mplus1p-Regular-cmap4-testing.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_map_t *mapping = hb_map_create ();
+  hb_face_collect_nominal_glyph_mapping (face, mapping, NULL);
+  g_assert_cmpuint (hb_map_get_population (mapping), >, 0);
+
+  /* Enough lookups per page to go through all of the lookup paths. */
+  for (unsigned round = 0; round < 3; round++)
+    for (hb_codepoint_t u = 0; u < 0x20000; u++)
+    {
+      hb_codepoint_t g = 0;
+      hb_bool_t found = hb_font_get_nominal_glyph (font, u, &g);
+      hb_codepoint_t expected = hb_map_get (mapping, u);
+      if (expected == HB_MAP_VALUE_INVALID)
+	g_assert_false (found);
+      else
+      {
+	g_assert_true (found);
+	g_assert_cmpuint (g, ==, expected);
+      }
+    }
+
+  hb_map_destroy (mapping);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+serial_executor (hb_task_func_t  func,
+		 void           *task_data,
+		 unsigned int    num_tasks,
+		 void           *user_data)
+{
+  unsigned int *calls = (unsigned int *) user_data;
+  unsigned int i;
+
+  (*calls)++;
+  for (i = num_tasks; i; i--)
+    func (task_data, i - 1);
+}
+
+static void
+test_ot_face_warmup (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_face_t *cold = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font, *cold_font;
+  hb_tag_t tags[] = {HB_OT_TAG_GSUB, HB_OT_TAG_GPOS, HB_TAG ('c','m','a','p')};
+  unsigned int calls = 0;
+  hb_codepoint_t cp;
+
+  hb_face_warmup (face, NULL, 0, serial_executor, &calls);
+  g_assert_cmpuint (calls, ==, 1);
+
+  /* Explicit tags, inline; already loaded tables are left alone. */
+  hb_face_warmup (face, tags, G_N_ELEMENTS (tags), NULL, NULL);
+  hb_face_warmup (face, tags, 0, serial_executor, &calls);
+  g_assert_cmpuint (calls, ==, 1);
+
+  g_assert_cmpuint (hb_face_get_glyph_count (face), ==, hb_face_get_glyph_count (cold));
+
+  font = hb_font_create (face);
+  cold_font = hb_font_create (cold);
+  for (cp = 'a'; cp <= 'c'; cp++)
+    g_assert_cmpint (test_font (font, cp), ==, test_font (cold_font, cp));
+
+  hb_face_warmup (hb_face_get_empty (), NULL, 0, serial_executor, &calls);
+
+  hb_font_destroy (cold_font);
+  hb_font_destroy (font);
+  hb_face_destroy (cold);
+  hb_face_destroy (face);
+}
+
+typedef struct
+{
+  uint64_t digests[64];
+  unsigned int lengths[64];
+  unsigned int count;
+  unsigned int hits;
+} sanitize_store_t;
+
+static hb_bool_t
+sanitize_store_lookup (const hb_face_t *face HB_UNUSED,
+		       hb_tag_t         table_tag HB_UNUSED,
+		       uint64_t         digest,
+		       unsigned int     length,
+		       void            *user_data)
+{
+  sanitize_store_t *store = (sanitize_store_t *) user_data;
+  unsigned int i;
+
+  for (i = 0; i < store->count; i++)
+    if (store->digests[i] == digest && store->lengths[i] == length)
+    {
+      store->hits++;
+      return TRUE;
+    }
+  return FALSE;
+}
+
+static void
+sanitize_store_record (const hb_face_t *face HB_UNUSED,
+		       hb_tag_t         table_tag HB_UNUSED,
+		       uint64_t         digest,
+		       unsigned int     length,
+		       void            *user_data)
+{
+  sanitize_store_t *store = (sanitize_store_t *) user_data;
+
+  g_assert_cmpuint (store->count, <, G_N_ELEMENTS (store->digests));
+  store->digests[store->count] = digest;
+  store->lengths[store->count] = length;
+  store->count++;
+}
+
+static void
+test_ot_face_sanitize_cache (void)
+{
+  static const uint8_t key[16] = {0x3a, 0x91, 0x5c, 0x07, 0xe2, 0x48, 0xbd, 0x16,
+				  0x6f, 0xd3, 0x20, 0x8e, 0x75, 0xc9, 0x04, 0xab};
+  static const uint8_t other_key[16] = {0x3a, 0x91, 0x5c, 0x07, 0xe2, 0x48, 0xbd, 0x16,
+					0x6f, 0xd3, 0x20, 0x8e, 0x75, 0xc9, 0x04, 0xac};
+  sanitize_store_t store = {{0}, {0}, 0, 0};
+  hb_face_t *face, *cold;
+  hb_font_t *font, *cold_font;
+  unsigned int recorded;
+  hb_codepoint_t cp;
+
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_face_set_sanitize_cache_funcs (face, key, sanitize_store_lookup, sanitize_store_record, &store, NULL);
+  font = hb_font_create (face);
+  test_font (font, 'a');
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+
+  recorded = store.count;
+  g_assert_cmpuint (recorded, >, 0);
+  g_assert_cmpuint (store.hits, ==, 0);
+
+  /* Same bytes again: everything recorded is found, nothing new recorded. */
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_face_set_sanitize_cache_funcs (face, key, sanitize_store_lookup, sanitize_store_record, &store, NULL);
+  cold = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  font = hb_font_create (face);
+  cold_font = hb_font_create (cold);
+  for (cp = 'a'; cp <= 'c'; cp++)
+    g_assert_cmpint (test_font (font, cp), ==, test_font (cold_font, cp));
+  g_assert_cmpuint (store.hits, ==, recorded);
+  g_assert_cmpuint (store.count, ==, recorded);
+  hb_font_destroy (cold_font);
+  hb_font_destroy (font);
+  hb_face_destroy (cold);
+  hb_face_destroy (face);
+
+  /* Different bytes are not mistaken for the recorded ones. */
+  store.hits = 0;
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.a.retaingids.ttf");
+  hb_face_set_sanitize_cache_funcs (face, key, sanitize_store_lookup, NULL, &store, NULL);
+  font = hb_font_create (face);
+  test_font (font, 'a');
+  g_assert_cmpuint (store.hits, <, recorded);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+
+  /* Nor are the same bytes hashed under another key. */
+  store.hits = 0;
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_face_set_sanitize_cache_funcs (face, other_key, sanitize_store_lookup, NULL, &store, NULL);
+  font = hb_font_create (face);
+  test_font (font, 'a');
+  g_assert_cmpuint (store.hits, ==, 0);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+shape_to_string (hb_font_t *font, const char *text, char *out, unsigned int size)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  hb_buffer_serialize_glyphs (buffer, 0, hb_buffer_get_length (buffer), out, size, NULL,
+			      font, HB_BUFFER_SERIALIZE_FORMAT_TEXT, HB_BUFFER_SERIALIZE_FLAG_DEFAULT);
+  hb_buffer_destroy (buffer);
+}
+
+static void
+test_ot_face_accelerator_snapshot (void)
+{
+  const char *text = "\xd8\xa8\xd8\xb3\xd9\x85 \xd8\xa7\xd9\x84\xd9\x84\xd9\x87 1234";
+  hb_face_t *face = hb_test_open_font_file ("fonts/Estedad-VF.ttf");
+  hb_face_t *other = hb_test_open_font_file ("fonts/Mada-VF.ttf");
+  hb_face_t *attached = hb_test_open_font_file ("fonts/Estedad-VF.ttf");
+  hb_font_t *font, *attached_font;
+  hb_blob_t *snapshot, *truncated;
+  char expected[1024], actual[1024], name[64];
+  hb_codepoint_t gid, num_glyphs;
+
+  snapshot = hb_face_serialize_accelerators (face);
+  g_assert_cmpuint (hb_blob_get_length (snapshot), >, 0);
+
+  /* Only attaches to a face of the same font data, and only once. */
+  g_assert_false (hb_face_attach_accelerators (other, snapshot));
+  truncated = hb_blob_create_sub_blob (snapshot, 0, hb_blob_get_length (snapshot) - 8);
+  g_assert_false (hb_face_attach_accelerators (attached, truncated));
+  g_assert_false (hb_face_attach_accelerators (attached, hb_blob_get_empty ()));
+  g_assert_true (hb_face_attach_accelerators (attached, snapshot));
+  g_assert_false (hb_face_attach_accelerators (attached, snapshot));
+  hb_blob_destroy (truncated);
+  hb_blob_destroy (snapshot);
+
+  font = hb_font_create (face);
+  attached_font = hb_font_create (attached);
+
+  shape_to_string (font, text, expected, sizeof (expected));
+  shape_to_string (attached_font, text, actual, sizeof (actual));
+  g_assert_cmpstr (actual, ==, expected);
+
+  num_glyphs = hb_face_get_glyph_count (face);
+  for (gid = 0; gid < num_glyphs; gid++)
+  {
+    hb_codepoint_t found = HB_CODEPOINT_INVALID;
+    if (!hb_font_get_glyph_name (font, gid, name, sizeof (name)))
+      continue;
+    g_assert_true (hb_font_get_glyph_from_name (attached_font, name, -1, &found));
+    g_assert_true (hb_font_get_glyph_name (attached_font, found, actual, sizeof (actual)));
+    g_assert_cmpstr (actual, ==, name);
+  }
+
+  hb_font_destroy (attached_font);
+  hb_font_destroy (font);
+  hb_face_destroy (attached);
+  hb_face_destroy (other);
+  hb_face_destroy (face);
+}
+
+static unsigned int
+face_memory_usage (hb_face_t *face, hb_tag_t tag)
+{
+  hb_tag_t tags[128];
+  unsigned int sizes[128];
+  unsigned int count = G_N_ELEMENTS (tags);
+  unsigned int total = 0, i;
+
+  g_assert_cmpuint (hb_face_get_memory_usage (face, 0, &count, tags, sizes), ==, count);
+  for (i = 0; i < count; i++)
+    if (tag == HB_TAG_NONE || tags[i] == tag)
+      total += sizes[i];
+  return total;
+}
+
+static void
+test_ot_face_memory_usage (void)
+{
+  const char *text = "\xd8\xa8\xd8\xb3\xd9\x85 \xd8\xa7\xd9\x84\xd9\x84\xd9\x87 1234";
+  hb_face_t *face = hb_test_open_font_file ("fonts/Estedad-VF.ttf");
+  hb_font_t *font = hb_font_create (face);
+  char expected[1024], actual[1024];
+  unsigned int count = 0, before, loaded, trimmed, gsub;
+  hb_tag_t tag;
+  hb_codepoint_t gid;
+
+  /* The face itself comes first. */
+  count = 1;
+  g_assert_cmpuint (hb_face_get_memory_usage (face, 0, &count, &tag, NULL), >=, 1);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (tag, ==, HB_TAG_NONE);
+  before = face_memory_usage (face, HB_TAG_NONE);
+  g_assert_cmpuint (before, >, 0);
+
+  shape_to_string (font, text, expected, sizeof (expected));
+  hb_font_get_glyph_from_name (font, "space", -1, &gid);
+  loaded = face_memory_usage (face, HB_TAG_NONE);
+  gsub = face_memory_usage (face, HB_OT_TAG_GSUB);
+  g_assert_cmpuint (loaded, >, before);
+  g_assert_cmpuint (gsub, >, 0);
+
+  /* Offset past the end returns nothing. */
+  count = 1;
+  g_assert_cmpuint (hb_face_get_memory_usage (face, 1000, &count, &tag, NULL), >, 1);
+  g_assert_cmpuint (count, ==, 0);
+
+  hb_face_trim (face);
+  trimmed = face_memory_usage (face, HB_TAG_NONE);
+  g_assert_cmpuint (trimmed, <, loaded);
+  g_assert_cmpuint (face_memory_usage (face, HB_OT_TAG_GSUB), <, gsub);
+
+  /* Everything trimmed is rebuilt on demand. */
+  shape_to_string (font, text, actual, sizeof (actual));
+  g_assert_cmpstr (actual, ==, expected);
+
+  hb_face_trim (hb_face_get_empty ());
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -220,6 +522,11 @@ main (int argc, char **argv)
 
   hb_test_add (test_ot_face_empty);
   hb_test_add (test_ot_var_axis_on_zero_named_instance);
+  hb_test_add (test_ot_face_nominal_glyphs_repeated);
+  hb_test_add (test_ot_face_warmup);
+  hb_test_add (test_ot_face_sanitize_cache);
+  hb_test_add (test_ot_face_accelerator_snapshot);
+  hb_test_add (test_ot_face_memory_usage);
 
   return hb_test_run();
 }
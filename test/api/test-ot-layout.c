@@ -215,6 +215,31 @@ test_ot_layout_language_get_feature_tags (void)
   hb_face_destroy (face);
 }
 
+static void
+test_ot_layout_table_get_coverage_bitmap_memory (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoNastaliqUrdu-Regular.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+
+  /* Bitmaps are built as lookups get used. */
+  g_assert_cmpuint (hb_ot_layout_table_get_coverage_bitmap_memory (face, HB_OT_TAG_GSUB), ==, 0);
+  g_assert_cmpuint (hb_ot_layout_table_get_coverage_bitmap_memory (face, HB_OT_TAG_GPOS), ==, 0);
+
+  hb_buffer_add_utf8 (buffer, "\xd8\xa8\xd8\xb3\xd9\x85 \xd8\xa7\xd9\x84\xd9\x84\xd9\x87", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+
+  g_assert_cmpuint (hb_ot_layout_table_get_coverage_bitmap_memory (face, HB_OT_TAG_GSUB), >, 0);
+  g_assert_cmpuint (hb_ot_layout_table_get_coverage_bitmap_memory (face, HB_OT_TAG_GSUB), <=, 256 * 1024);
+  g_assert_cmpuint (hb_ot_layout_table_get_coverage_bitmap_memory (face, HB_OT_TAG_GPOS), >, 0);
+  g_assert_cmpuint (hb_ot_layout_table_get_coverage_bitmap_memory (face, HB_TAG ('m','o','r','x')), ==, 0);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -224,5 +249,6 @@ main (int argc, char **argv)
   hb_test_add (test_ot_layout_script_get_language_tags);
   hb_test_add (test_ot_layout_table_get_feature_tags);
   hb_test_add (test_ot_layout_language_get_feature_tags);
+  hb_test_add (test_ot_layout_table_get_coverage_bitmap_memory);
   return hb_test_run ();
 }
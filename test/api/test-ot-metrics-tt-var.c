@@ -130,6 +130,98 @@ test_advance_tt_var_hvarvvar (void)
   hb_font_destroy (font);
 }
 
+static void
+test_advance_tt_var_switch_instances (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSerifVariable-Roman-VVAR.abc.ttf");
+  g_assert_true (face);
+  hb_font_t *font = hb_font_create (face);
+  g_assert_true (font);
+
+  /* More instances than we keep caches for, visited repeatedly. */
+  float weights[] = {200.f, 700.f, 300.f, 900.f, 500.f, 400.f};
+  hb_position_t expected_x[G_N_ELEMENTS (weights)];
+  hb_position_t expected_y[G_N_ELEMENTS (weights)];
+  for (unsigned i = 0; i < G_N_ELEMENTS (weights); i++)
+  {
+    hb_position_t x, y;
+    hb_font_t *fresh = hb_font_create (face);
+    hb_font_set_var_coords_design (fresh, &weights[i], 1);
+    hb_font_get_glyph_advance_for_direction (fresh, 1, HB_DIRECTION_LTR, &x, &y);
+    expected_x[i] = x;
+    hb_font_get_glyph_advance_for_direction (fresh, 1, HB_DIRECTION_TTB, &x, &y);
+    expected_y[i] = y;
+    hb_font_destroy (fresh);
+  }
+  g_assert_cmpint (expected_x[0], !=, expected_x[1]);
+
+  for (unsigned round = 0; round < 3; round++)
+    for (unsigned i = 0; i < G_N_ELEMENTS (weights); i++)
+    {
+      unsigned j = round == 1 ? i % 2 : i;
+      hb_position_t x, y;
+      hb_font_set_var_coords_design (font, &weights[j], 1);
+      hb_font_get_glyph_advance_for_direction (font, 1, HB_DIRECTION_LTR, &x, &y);
+      g_assert_cmpint (x, ==, expected_x[j]);
+      hb_font_get_glyph_advance_for_direction (font, 1, HB_DIRECTION_TTB, &x, &y);
+      g_assert_cmpint (y, ==, expected_y[j]);
+    }
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_advance_tt_var_cache_size (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSerifVariable-Roman-VVAR.abc.ttf");
+  g_assert_true (face);
+  hb_font_t *font = hb_font_create (face);
+  g_assert_true (font);
+
+  float weight = 700.f;
+  hb_font_set_var_coords_design (font, &weight, 1);
+
+  unsigned size, hits, misses;
+  hb_ot_font_get_advance_cache_stats (font, &size, &hits, &misses);
+  g_assert_cmpuint (size, ==, 256);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+
+  hb_position_t advance = hb_font_get_glyph_h_advance (font, 1);
+  g_assert_cmpint (advance, ==, hb_font_get_glyph_h_advance (font, 1));
+  hb_ot_font_get_advance_cache_stats (font, NULL, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 1);
+
+  hb_ot_font_set_advance_cache_size (font, 1000);
+  hb_ot_font_get_advance_cache_stats (font, &size, &hits, &misses);
+  g_assert_cmpuint (size, ==, 1024);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  g_assert_cmpint (advance, ==, hb_font_get_glyph_h_advance (font, 1));
+  g_assert_cmpint (advance, ==, hb_font_get_glyph_h_advance (font, 1));
+  hb_ot_font_get_advance_cache_stats (font, NULL, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 1);
+
+  hb_ot_font_set_advance_cache_size (font, 0);
+  hb_ot_font_get_advance_cache_stats (font, &size, NULL, NULL);
+  g_assert_cmpuint (size, ==, 256);
+
+  /* Not using hb-ot font functions. */
+  hb_font_t *sub_font = hb_font_create_sub_font (font);
+  hb_ot_font_set_advance_cache_size (sub_font, 4096);
+  hb_ot_font_get_advance_cache_stats (sub_font, &size, &hits, &misses);
+  g_assert_cmpuint (size, ==, 0);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  hb_font_destroy (sub_font);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 static void
 test_advance_tt_var_anchor (void)
 {
@@ -252,6 +344,8 @@ main (int argc, char **argv)
   hb_test_add (test_extents_tt_var);
   hb_test_add (test_advance_tt_var_nohvar);
   hb_test_add (test_advance_tt_var_hvarvvar);
+  hb_test_add (test_advance_tt_var_switch_instances);
+  hb_test_add (test_advance_tt_var_cache_size);
   hb_test_add (test_advance_tt_var_anchor);
   hb_test_add (test_extents_tt_var_comp);
   hb_test_add (test_advance_tt_var_comp_v);
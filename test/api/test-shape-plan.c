@@ -318,6 +318,75 @@ test_ot_shape_plan_get_feature_tags_userfeatures_disablenondeafult (void)
   hb_face_destroy (face);
 }
 
+static void
+test_shape_plan_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  hb_shape_plan_t *plans[3], *plan, *other;
+  unsigned int hits, misses, size, i;
+  const char *languages[3] = {"en", "fr", "de"};
+
+  props.script = HB_SCRIPT_LATIN;
+  props.direction = HB_DIRECTION_LTR;
+
+  hb_face_get_shape_plan_cache_stats (face, &hits, &misses, &size);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  g_assert_cmpuint (size, ==, 0);
+
+  for (i = 0; i < 3; i++)
+  {
+    props.language = hb_language_from_string (languages[i], -1);
+    plans[i] = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  }
+  props.language = hb_language_from_string ("en", -1);
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert_true (plan == plans[0]);
+  hb_shape_plan_destroy (plan);
+
+  hb_face_get_shape_plan_cache_stats (face, &hits, &misses, &size);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 3);
+  g_assert_cmpuint (size, ==, 3);
+
+  /* "fr" is the least-recently used, so it goes first. */
+  hb_face_set_shape_plan_cache_capacity (face, 2);
+  hb_face_get_shape_plan_cache_stats (face, NULL, NULL, &size);
+  g_assert_cmpuint (size, ==, 2);
+
+  props.language = hb_language_from_string ("de", -1);
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert_true (plan == plans[2]);
+  hb_shape_plan_destroy (plan);
+
+  props.language = hb_language_from_string ("fr", -1);
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert_true (plan != plans[1]);
+  g_assert_cmpstr (hb_shape_plan_get_shaper (plans[1]), ==, "ot");
+  hb_shape_plan_destroy (plan);
+
+  hb_face_get_shape_plan_cache_stats (face, &hits, &misses, &size);
+  g_assert_cmpuint (hits, ==, 2);
+  g_assert_cmpuint (misses, ==, 4);
+  g_assert_cmpuint (size, ==, 2);
+
+  /* Disabled. */
+  hb_face_set_shape_plan_cache_capacity (face, 0);
+  hb_face_get_shape_plan_cache_stats (face, NULL, NULL, &size);
+  g_assert_cmpuint (size, ==, 0);
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  other = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert_true (plan != other);
+  hb_shape_plan_destroy (plan);
+  hb_shape_plan_destroy (other);
+
+  for (i = 0; i < 3; i++)
+    hb_shape_plan_destroy (plans[i]);
+  hb_face_destroy (face);
+}
+
+
 int
 main (int argc, char **argv)
 {
@@ -330,6 +399,7 @@ main (int argc, char **argv)
   hb_test_add (test_ot_shape_plan_get_feature_tags_userfeatures_disable);
   hb_test_add (test_ot_shape_plan_get_feature_tags_userfeatures_disablepartial);
   hb_test_add (test_ot_shape_plan_get_feature_tags_userfeatures_disablenondeafult);
+  hb_test_add (test_shape_plan_cache);
 
   return hb_test_run();
 }
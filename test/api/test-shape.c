@@ -180,6 +180,239 @@ test_shape_clusters (void)
 }
 
 
+
+static void
+reverse_executor (hb_task_func_t  func,
+		  void           *task_data,
+		  unsigned int    num_tasks,
+		  void           *user_data)
+{
+  unsigned int *calls = (unsigned int *) user_data;
+  unsigned int i;
+
+  (*calls)++;
+  for (i = num_tasks; i; i--)
+    func (task_data, i - 1);
+}
+
+static void
+test_shape_parallel_text (hb_font_t *font, const char *word, hb_direction_t direction)
+{
+  hb_buffer_t *serial, *parallel;
+  unsigned int i, calls = 0;
+
+  serial = hb_buffer_create ();
+  for (i = 0; i < 1000; i++)
+  {
+    hb_buffer_add_utf8 (serial, word, -1, 0, -1);
+    hb_buffer_add_utf8 (serial, i % 7 ? " " : "  ", -1, 0, -1);
+  }
+  hb_buffer_set_direction (serial, direction);
+  hb_buffer_guess_segment_properties (serial);
+  hb_buffer_set_flags (serial, HB_BUFFER_FLAG_BOT | HB_BUFFER_FLAG_EOT);
+
+  parallel = hb_buffer_create ();
+  hb_buffer_append (parallel, serial, 0, -1);
+  hb_buffer_set_direction (parallel, direction);
+  hb_buffer_guess_segment_properties (parallel);
+  hb_buffer_set_flags (parallel, HB_BUFFER_FLAG_BOT | HB_BUFFER_FLAG_EOT);
+
+  hb_shape (font, serial, NULL, 0);
+  g_assert_true (hb_shape_parallel (font, parallel, NULL, 0, reverse_executor, &calls));
+
+  g_assert_cmpuint (calls, >, 0);
+  g_assert_cmpuint (hb_buffer_get_length (parallel), ==, hb_buffer_get_length (serial));
+  g_assert_cmpuint (hb_buffer_diff (parallel, serial, HB_CODEPOINT_INVALID, 0), ==, HB_BUFFER_DIFF_FLAG_EQUAL);
+
+  hb_buffer_destroy (serial);
+  hb_buffer_destroy (parallel);
+}
+
+static void
+test_shape_parallel (void)
+{
+  hb_face_t *face;
+  hb_font_t *font;
+  hb_buffer_t *buffer;
+  unsigned int calls = 0;
+
+  face = hb_test_open_font_file ("fonts/NotoNastaliqUrdu-Regular.ttf");
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+
+  test_shape_parallel_text (font, "\xd9\x81\xd9\x8e\xd9\x86\xd9\x91\xdb\x8c", HB_DIRECTION_INVALID);
+  test_shape_parallel_text (font, "\xd8\xa8\xdb\x8c\xd9\x86", HB_DIRECTION_INVALID);
+  test_shape_parallel_text (font, "Ta", HB_DIRECTION_LTR);
+
+  /* Short buffers are shaped serially. */
+  buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, "Ta Ta", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  g_assert_true (hb_shape_parallel (font, buffer, NULL, 0, reverse_executor, &calls));
+  g_assert_cmpuint (calls, ==, 0);
+  g_assert_cmpuint (hb_buffer_get_content_type (buffer), ==, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+  hb_buffer_destroy (buffer);
+
+  hb_font_destroy (font);
+}
+
+static hb_buffer_t *
+create_incremental_buffer (const char *prefix, const char *middle, const char *suffix)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  char *text = g_strconcat (prefix, middle, suffix, NULL);
+
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_buffer_set_flags (buffer, HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT);
+  g_free (text);
+
+  return buffer;
+}
+
+static void
+test_shape_incremental_edit (hb_font_t  *font,
+			     const char *prefix,
+			     const char *old_middle,
+			     const char *new_middle,
+			     const char *suffix)
+{
+  hb_buffer_t *previous, *expected, *buffer;
+  unsigned int start = strlen (prefix);
+
+  previous = create_incremental_buffer (prefix, old_middle, suffix);
+  hb_shape (font, previous, NULL, 0);
+
+  expected = create_incremental_buffer (prefix, new_middle, suffix);
+  hb_shape (font, expected, NULL, 0);
+
+  buffer = create_incremental_buffer (prefix, new_middle, suffix);
+  g_assert_true (hb_shape_incremental (font, buffer, NULL, 0, previous,
+				       start,
+				       start + strlen (old_middle),
+				       start + strlen (new_middle)));
+
+  g_assert_cmpuint (hb_buffer_diff (buffer, expected, HB_CODEPOINT_INVALID, 0), ==, HB_BUFFER_DIFF_FLAG_EQUAL);
+
+  hb_buffer_destroy (previous);
+  hb_buffer_destroy (expected);
+  hb_buffer_destroy (buffer);
+}
+
+static void
+test_shape_incremental (void)
+{
+  hb_face_t *face;
+  hb_font_t *font;
+
+  face = hb_test_open_font_file ("fonts/NotoNastaliqUrdu-Regular.ttf");
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+
+  /* Replace a word, join two words, insert, and delete at either end. */
+  test_shape_incremental_edit (font, "\xd8\xa8\xdb\x8c\xd9\x86 ", "\xd9\x81\xd9\x8e\xd9\x86", "\xd8\xa8\xdb\x8c", " \xd8\xa8\xdb\x8c\xd9\x86");
+  test_shape_incremental_edit (font, "\xd8\xa8\xdb\x8c\xd9\x86", " ", "", "\xd8\xa8\xdb\x8c\xd9\x86");
+  test_shape_incremental_edit (font, "\xd8\xa8\xdb\x8c", "", "\xd9\x86\xd9\x86", "\xd9\x86 \xd8\xa8");
+  test_shape_incremental_edit (font, "", "\xd8\xa8", "", "\xdb\x8c\xd9\x86 \xd8\xa8");
+  test_shape_incremental_edit (font, "\xd8\xa8\xdb\x8c\xd9\x86 \xd8\xa8", "", "\xdb\x8c", "");
+
+  hb_font_destroy (font);
+}
+
+static void
+test_shape_cache (void)
+{
+  hb_blob_t *blob;
+  hb_face_t *face;
+  hb_font_funcs_t *ffuncs;
+  hb_font_t *font;
+  hb_buffer_t *buffer;
+  unsigned int hits, misses, memory;
+  unsigned int len;
+  hb_glyph_info_t *glyphs;
+
+  blob = hb_blob_create (test_data, sizeof (test_data), HB_MEMORY_MODE_READONLY, NULL, NULL);
+  face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_font_set_scale (font, 10, 10);
+
+  ffuncs = hb_font_funcs_create ();
+  hb_font_funcs_set_glyph_h_advance_func (ffuncs, glyph_h_advance_func, NULL, NULL);
+  hb_font_funcs_set_nominal_glyph_func (ffuncs, glyph_func, NULL, NULL);
+  hb_font_set_funcs (font, ffuncs, NULL, NULL);
+  hb_font_funcs_destroy (ffuncs);
+
+  hb_font_get_shape_cache_stats (font, &hits, &misses, &memory);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  g_assert_cmpuint (memory, ==, 0);
+
+  hb_font_set_shape_cache (font, 1 << 16);
+
+  test_font (font);
+  hb_font_get_shape_cache_stats (font, &hits, &misses, &memory);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 1);
+  g_assert_cmpuint (memory, >, 0);
+
+  test_font (font);
+  hb_font_get_shape_cache_stats (font, &hits, &misses, NULL);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 1);
+
+  /* Cached clusters are relative to the input. */
+  buffer = hb_buffer_create ();
+  hb_buffer_set_direction (buffer, HB_DIRECTION_LTR);
+  hb_buffer_set_content_type (buffer, HB_BUFFER_CONTENT_TYPE_UNICODE);
+  hb_buffer_add (buffer, 'T', 10);
+  hb_buffer_add (buffer, 'e', 11);
+  hb_buffer_add (buffer, 's', 12);
+  hb_buffer_add (buffer, 'T', 20);
+  hb_shape (font, buffer, NULL, 0);
+  hb_font_get_shape_cache_stats (font, &hits, NULL, NULL);
+  g_assert_cmpuint (hits, ==, 2);
+  len = hb_buffer_get_length (buffer);
+  glyphs = hb_buffer_get_glyph_infos (buffer, NULL);
+  g_assert_cmpuint (len, ==, 4);
+  g_assert_cmpuint (glyphs[0].cluster, ==, 10);
+  g_assert_cmpuint (glyphs[3].cluster, ==, 20);
+  hb_buffer_destroy (buffer);
+
+  /* Different context is a different key. */
+  buffer = hb_buffer_create ();
+  hb_buffer_set_direction (buffer, HB_DIRECTION_LTR);
+  hb_buffer_add_utf8 (buffer, "TesTs", 5, 0, 4);
+  hb_shape (font, buffer, NULL, 0);
+  hb_font_get_shape_cache_stats (font, &hits, &misses, NULL);
+  g_assert_cmpuint (hits, ==, 2);
+  g_assert_cmpuint (misses, ==, 2);
+  hb_buffer_destroy (buffer);
+
+  /* Changing the font invalidates the cache. */
+  hb_font_set_scale (font, 20, 20);
+  test_font (font);
+  hb_font_get_shape_cache_stats (font, &hits, &misses, NULL);
+  g_assert_cmpuint (hits, ==, 2);
+  g_assert_cmpuint (misses, ==, 3);
+
+  /* Cache doesn't grow beyond its budget. */
+  hb_font_set_shape_cache (font, 1);
+  hb_font_get_shape_cache_stats (font, NULL, NULL, &memory);
+  g_assert_cmpuint (memory, ==, 0);
+  test_font (font);
+  hb_font_get_shape_cache_stats (font, NULL, NULL, &memory);
+  g_assert_cmpuint (memory, ==, 0);
+
+  hb_font_set_shape_cache (font, 0);
+  hb_font_get_shape_cache_stats (font, &hits, &misses, &memory);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+
+  hb_font_destroy (font);
+}
+
 static void
 test_shape_list (void)
 {
@@ -200,6 +433,9 @@ main (int argc, char **argv)
 
   hb_test_add (test_shape);
   hb_test_add (test_shape_clusters);
+  hb_test_add (test_shape_parallel);
+  hb_test_add (test_shape_incremental);
+  hb_test_add (test_shape_cache);
   /* TODO test fallback shaper */
   /* TODO test shaper_full */
   hb_test_add (test_shape_list);
@@ -1,4 +1,5 @@
 #include <cassert>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -91,6 +92,33 @@ static void shape (const test_input_t &input,
   hb_blob_destroy (text_blob);
 }
 
+/* Returns wall-clock milliseconds. */
+static double run_threads (const test_input_t &test_input,
+			   hb_font_t *font,
+			   unsigned count)
+{
+  {
+    std::unique_lock<std::mutex> lk (cv_m);
+    ready = false;
+  }
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < count; i++)
+    threads.push_back (std::thread (shape, test_input, font));
+
+  auto start = std::chrono::steady_clock::now ();
+  {
+    std::unique_lock<std::mutex> lk (cv_m);
+    ready = true;
+  }
+  cv.notify_all();
+
+  for (unsigned i = 0; i < count; i++)
+    threads[i].join ();
+
+  return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+}
+
 static void test_backend (const char *backend,
 			  bool variable,
 			  const test_input_t &test_input)
@@ -128,18 +156,13 @@ static void test_backend (const char *backend,
   bool ret = hb_font_set_funcs_using (font, backend);
   assert (ret);
 
-  std::vector<std::thread> threads;
-  for (unsigned i = 0; i < num_threads; i++)
-    threads.push_back (std::thread (shape, test_input, font));
-
-  {
-    std::unique_lock<std::mutex> lk (cv_m);
-    ready = true;
-  }
-  cv.notify_all();
-
-  for (unsigned i = 0; i < num_threads; i++)
-    threads[i].join ();
+  /* Each thread shapes the whole text, so with perfect scaling the time
+   * stays the same as threads are added.  Report it against one thread,
+   * to catch contention on the font's shared caches. */
+  double single = run_threads (test_input, font, 1);
+  double multi = num_threads > 1 ? run_threads (test_input, font, num_threads) : single;
+  printf ("  1 thread: %.1fms; %u threads: %.1fms; scaling efficiency %.0f%%\n",
+	  single, num_threads, multi, 100. * single / multi);
 
   hb_font_destroy (font);
 }